@@ -0,0 +1,71 @@
+// the JSON output shared by the benchmarks, results go to stdout as
+//   { "section": [ {record}, ... ], ... }
+#ifndef JSONRECORD_H_
+#define JSONRECORD_H_
+
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// just enough JSON for flat records of numbers, bools and strings
+class JsonRecord
+{
+public:
+  JsonRecord &add(const char *_key, const std::string &_value)
+  {
+    next(_key);
+    m_text<<'"'<<_value<<'"';
+    return *this;
+  }
+  JsonRecord &add(const char *_key, const char *_value) { return add(_key, std::string(_value)); }
+  JsonRecord &add(const char *_key, bool _value)
+  {
+    next(_key);
+    m_text<<(_value ? "true" : "false");
+    return *this;
+  }
+  // JSON has no nan or inf, they are written as null
+  JsonRecord &add(const char *_key, double _value)
+  {
+    next(_key);
+    if (std::isfinite(_value))
+    {
+      m_text<<_value;
+    }
+    else
+    {
+      m_text<<"null";
+    }
+    return *this;
+  }
+  template <typename T>
+  JsonRecord &add(const char *_key, T _value)
+  {
+    next(_key);
+    m_text<<_value;
+    return *this;
+  }
+  std::string str() const { return m_text.str()+"}"; }
+private:
+  void next(const char *_key)
+  {
+    m_text<<(m_first ? "{" : ", ")<<'"'<<_key<<"\": ";
+    m_first = false;
+  }
+  std::ostringstream m_text;
+  bool m_first = true;
+};
+
+inline void writeSection(const char *_name, const std::vector<std::string> &_records, bool _last)
+{
+  std::cout<<"  \""<<_name<<"\": [\n";
+  for (size_t i=0; i<_records.size(); ++i)
+  {
+    std::cout<<"    "<<_records[i]<<(i+1<_records.size() ? ",\n" : "\n");
+  }
+  std::cout<<"  ]"<<(_last ? "\n" : ",\n");
+}
+
+#endif
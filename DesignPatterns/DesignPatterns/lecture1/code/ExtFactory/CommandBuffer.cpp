@@ -0,0 +1,20 @@
+#include "CommandBuffer.h"
+
+void CommandBuffer::push(Type _type, const void *_data, size_t _size)
+{
+  Header h{_type, static_cast<uint32_t>(_size)};
+  size_t offset = m_data.size();
+  m_data.resize(offset+sizeof(h)+_size);
+  std::memcpy(&m_data[offset], &h, sizeof(h));
+  if (_size > 0)
+  {
+    std::memcpy(&m_data[offset+sizeof(h)], _data, _size);
+  }
+  ++m_count;
+}
+
+void CommandBuffer::append(const CommandBuffer &_other)
+{
+  m_data.insert(m_data.end(), _other.m_data.begin(), _other.m_data.end());
+  m_count += _other.m_count;
+}
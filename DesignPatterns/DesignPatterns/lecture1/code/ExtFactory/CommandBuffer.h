@@ -0,0 +1,126 @@
+#ifndef COMMANDBUFFER_H
+#define COMMANDBUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+///
+/// A recorded list of Renderer calls packed into one linear block of memory,
+/// a small header per command followed by its arguments as plain data. A
+/// renderer runs the whole list with one Renderer::execute call. The default
+/// execute still makes a virtual call per command, the built in backends
+/// override it with replay on their own final type so the list is decoded in
+/// one loop calling them directly. Buffers share nothing so each
+/// thread can record its own at the same time, clear() keeps the memory so a
+/// buffer can be reused every frame without allocating.
+class CommandBuffer
+{
+public:
+  enum class Type : uint8_t { LoadScene, SetViewportSize, SetCameraPos, SetLookAt, Render };
+  struct ViewportSize { int w; int h; };
+  struct Vector { double x; double y; double z; };
+
+  /// one recorded command as seen while reading the buffer back
+  class Command
+  {
+  public:
+    Command(Type _type, const unsigned char *_data, size_t _size) :
+      m_type(_type), m_data(_data), m_size(_size) {}
+    Type type() const { return m_type; }
+    /// the arguments, copied out as the arena makes no alignment promises
+    template <typename T>
+    T as() const
+    {
+      T value;
+      std::memcpy(&value, m_data, sizeof(T));
+      return value;
+    }
+    /// the file name of a LoadScene
+    std::string_view text() const { return std::string_view(reinterpret_cast<const char *>(m_data), m_size); }
+  private:
+    Type m_type;
+    const unsigned char *m_data;
+    size_t m_size;
+  };
+
+  explicit CommandBuffer(size_t _reserveBytes=4096) { m_data.reserve(_reserveBytes); }
+
+  void loadScene(std::string_view _filename) { push(Type::LoadScene, _filename.data(), _filename.size()); }
+  void setViewportSize(int _w, int _h) { pushValue(Type::SetViewportSize, ViewportSize{_w, _h}); }
+  void setCameraPos(double _x, double _y, double _z) { pushValue(Type::SetCameraPos, Vector{_x, _y, _z}); }
+  void setLookAt(double _x, double _y, double _z) { pushValue(Type::SetLookAt, Vector{_x, _y, _z}); }
+  void render() { push(Type::Render, nullptr, 0); }
+  /// add everything recorded in _other after what is here, for joining the
+  /// buffers recorded by several threads in a fixed order
+  void append(const CommandBuffer &_other);
+  void clear() { m_data.clear(); m_count = 0; }
+
+  size_t size() const { return m_count; }
+  bool empty() const { return m_count == 0; }
+  size_t bytes() const { return m_data.size(); }
+
+  /// calls _f(const Command &) for each command in the order recorded
+  template <typename F>
+  void forEach(F &&_f) const
+  {
+    size_t offset=0;
+    while (offset < m_data.size())
+    {
+      Header h;
+      std::memcpy(&h, &m_data[offset], sizeof(h));
+      _f(Command(h.type, &m_data[offset+sizeof(h)], h.size));
+      offset += sizeof(h)+h.size;
+    }
+  }
+
+  /// decode the buffer once, calling the matching method of _r for each
+  /// command. With a final renderer type the calls are direct.
+  template <typename R>
+  void replay(R &_r) const
+  {
+    forEach([&_r](const Command &_c)
+    {
+      switch (_c.type())
+      {
+        case Type::LoadScene : _r.loadScene(std::string(_c.text())); break;
+        case Type::SetViewportSize :
+        {
+          auto v = _c.as<ViewportSize>();
+          _r.setViewportSize(v.w, v.h);
+        }
+        break;
+        case Type::SetCameraPos :
+        {
+          auto v = _c.as<Vector>();
+          _r.setCameraPos(v.x, v.y, v.z);
+        }
+        break;
+        case Type::SetLookAt :
+        {
+          auto v = _c.as<Vector>();
+          _r.setLookAt(v.x, v.y, v.z);
+        }
+        break;
+        case Type::Render : _r.render(); break;
+      }
+    });
+  }
+
+private:
+  struct Header
+  {
+    Type type;
+    uint32_t size;
+  };
+  template <typename T>
+  void pushValue(Type _type, const T &_value) { push(_type, &_value, sizeof(T)); }
+  void push(Type _type, const void *_data, size_t _size);
+  std::vector<unsigned char> m_data;
+  size_t m_count = 0;
+};
+
+#endif
@@ -3,7 +3,7 @@
 #include <iostream>
 #include "Renderer.h"
 
-class DirectXRenderer : public Renderer
+class DirectXRenderer final : public Renderer
 {
 public:
   DirectXRenderer()=default;
@@ -12,6 +12,9 @@ public:
   void setCameraPos(double , double , double ) {;}
   void setLookAt(double , double , double ) {;}
   void render() {std::cout<<"DirectX Render\n";}
+  // decoded in one loop with direct calls, as OpenGLRenderer
+  void execute(const CommandBuffer &_commands) { _commands.replay(*this); }
+  void reset() {std::cout<<"DirectX reset\n";}
   ~DirectXRenderer(){std::cout<<"Direct X dtor called\n";}
   static Renderer *create() { return new DirectXRenderer; }
 
@@ -3,7 +3,7 @@
 #include <iostream>
 #include "Renderer.h"
 
-class GLES : public Renderer
+class GLES final : public Renderer
 {
 public:
 
@@ -12,6 +12,9 @@ public:
   void setCameraPos(double , double , double ) {;}
   void setLookAt(double , double , double ) {;}
   void render() {std::cout<<"GLES Render\n";}
+  // decoded in one loop with direct calls, as OpenGLRenderer
+  void execute(const CommandBuffer &_commands) { _commands.replay(*this); }
+  void reset() {std::cout<<"GLES reset\n";}
   ~GLES(){std::cout<<"GLES dtor called\n";}
   static Renderer *create() { return new GLES; }
 
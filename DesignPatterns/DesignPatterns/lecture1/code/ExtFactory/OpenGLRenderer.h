@@ -4,7 +4,7 @@
 #include "Renderer.h"
 
 
-class OpenGLRenderer : public Renderer
+class OpenGLRenderer final : public Renderer
 {
 public:
 
@@ -13,6 +13,9 @@ public:
   void setCameraPos(double , double , double ) {;}
   void setLookAt(double , double , double ) {;}
   void render() {std::cout<<"OpenGL Render\n";}
+  // one pass over the buffer, being final our own methods are called directly
+  void execute(const CommandBuffer &_commands) { _commands.replay(*this); }
+  void reset() {std::cout<<"OpenGL reset\n";}
   ~OpenGLRenderer(){std::cout<<"OpenGL dtor called\n";}
   static Renderer *create() { return new OpenGLRenderer; }
 
@@ -0,0 +1,75 @@
+#ifndef PERFECTHASH_H
+#define PERFECTHASH_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+///
+/// A perfect hash over a fixed set of N names worked out at compile time. The
+/// constructor searches for a seed that sends every name to its own slot of a
+/// power of two table at least twice the size of the set, so a lookup is one
+/// hash, one table read and one compare to reject names not in the set.
+template <size_t N>
+class PerfectHash
+{
+public:
+  static constexpr size_t TableSize = [] { size_t s=1; while (s < 2*N) s*=2; return s; }();
+
+  constexpr explicit PerfectHash(const std::array<std::string_view,N> &_names) : m_names(_names)
+  {
+    for (uint32_t seed=1; ; ++seed)
+    {
+      if (trySeed(seed))
+      {
+        m_seed = seed;
+        return;
+      }
+    }
+  }
+
+  /// index of _name in the set or -1
+  constexpr int find(std::string_view _name) const
+  {
+    int i = m_slots[hash(_name, m_seed) & (TableSize-1)];
+    return i >= 0 && m_names[i] == _name ? i : -1;
+  }
+  constexpr uint32_t seed() const { return m_seed; }
+
+  /// FNV-1a mixed with the seed
+  static constexpr uint32_t hash(std::string_view _name, uint32_t _seed)
+  {
+    uint32_t h = 2166136261u ^ (_seed*0x9e3779b9u);
+    for (char c : _name)
+    {
+      h = (h ^ static_cast<unsigned char>(c))*16777619u;
+    }
+    return h ^ (h >> 15);
+  }
+
+private:
+  constexpr bool trySeed(uint32_t _seed)
+  {
+    for (auto &s : m_slots)
+    {
+      s = -1;
+    }
+    for (size_t i=0; i<N; ++i)
+    {
+      int &slot = m_slots[hash(m_names[i], _seed) & (TableSize-1)];
+      if (slot != -1)
+      {
+        return false;
+      }
+      slot = static_cast<int>(i);
+    }
+    return true;
+  }
+
+  std::array<std::string_view,N> m_names{};
+  std::array<int,TableSize> m_slots{};
+  uint32_t m_seed = 0;
+};
+
+#endif
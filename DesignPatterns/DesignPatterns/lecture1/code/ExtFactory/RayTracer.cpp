@@ -0,0 +1,366 @@
+#include "RayTracer.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+  using Vec3 = RayTracer::Vec3;
+  constexpr int TileSize = 32;
+  constexpr int MaxDepth = 4;
+  constexpr double Epsilon = 1e-6;
+  constexpr double Ambient = 0.1;
+  constexpr double FieldOfView = 45.0;
+
+  Vec3 operator+(const Vec3 &_a, const Vec3 &_b) { return {_a.x+_b.x, _a.y+_b.y, _a.z+_b.z}; }
+  Vec3 operator-(const Vec3 &_a, const Vec3 &_b) { return {_a.x-_b.x, _a.y-_b.y, _a.z-_b.z}; }
+  Vec3 operator*(const Vec3 &_a, double _s) { return {_a.x*_s, _a.y*_s, _a.z*_s}; }
+  double dot(const Vec3 &_a, const Vec3 &_b) { return _a.x*_b.x+_a.y*_b.y+_a.z*_b.z; }
+  Vec3 cross(const Vec3 &_a, const Vec3 &_b)
+  {
+    return {_a.y*_b.z-_a.z*_b.y, _a.z*_b.x-_a.x*_b.z, _a.x*_b.y-_a.y*_b.x};
+  }
+  Vec3 normalize(const Vec3 &_v)
+  {
+    double l = std::sqrt(dot(_v, _v));
+    return l > 0.0 ? _v*(1.0/l) : _v;
+  }
+
+  uint8_t toByte(double _c)
+  {
+    // gamma 2.2 for display
+    double c = std::pow(std::clamp(_c, 0.0, 1.0), 1.0/2.2);
+    return static_cast<uint8_t>(c*255.0+0.5);
+  }
+
+  bool endsWith(const std::string &_s, const std::string &_end)
+  {
+    return _s.size() >= _end.size() && _s.compare(_s.size()-_end.size(), _end.size(), _end) == 0;
+  }
+}
+
+struct RayTracer::Hit
+{
+  double t;
+  Vec3 point;
+  Vec3 normal;
+  Vec3 colour;
+  double reflect;
+};
+
+RayTracer::RayTracer()
+{
+  reset();
+}
+
+void RayTracer::reset()
+{
+  defaultScene();
+  m_eye = {0.0, 2.0, 8.0};
+  m_lookAt = {0.0, 1.0, 0.0};
+  m_width = 640;
+  m_height = 480;
+  m_samples = 1;
+  m_output.clear();
+  m_pixels.clear();
+  // an idle pooled renderer shouldn't keep a thread per core waiting
+  m_pool.reset();
+}
+
+void RayTracer::defaultScene()
+{
+  m_spheres = {
+    {{-2.2, 1.0, 0.0}, 1.0, {0.9, 0.2, 0.2}, 0.2},
+    {{0.0, 1.0, -1.0}, 1.0, {0.9, 0.9, 0.9}, 0.6},
+    {{2.2, 1.0, 0.0}, 1.0, {0.2, 0.3, 0.9}, 0.2}
+  };
+  m_planes = { {{0.0, 1.0, 0.0}, 0.0, {0.8, 0.8, 0.8}, 0.1} };
+  m_lights = { {5.0, 8.0, 6.0} };
+  m_background = {0.5, 0.7, 1.0};
+}
+
+bool RayTracer::loadScene(const std::string &_filename)
+{
+  std::ifstream file(_filename);
+  if (!file)
+  {
+    return false;
+  }
+  std::vector<Sphere> spheres;
+  std::vector<Plane> planes;
+  std::vector<Vec3> lights;
+  Vec3 background = m_background;
+  std::string output = m_output;
+  std::string line;
+  while (std::getline(file, line))
+  {
+    std::istringstream in(line);
+    std::string kind;
+    if (!(in >> kind) || kind[0] == '#')
+    {
+      continue;
+    }
+    bool ok = true;
+    if (kind == "sphere")
+    {
+      Sphere s{};
+      ok = bool(in >> s.centre.x >> s.centre.y >> s.centre.z >> s.radius >> s.colour.x >> s.colour.y >> s.colour.z);
+      in >> s.reflect;
+      spheres.push_back(s);
+    }
+    else if (kind == "plane")
+    {
+      Plane p{};
+      ok = bool(in >> p.normal.x >> p.normal.y >> p.normal.z >> p.offset >> p.colour.x >> p.colour.y >> p.colour.z);
+      in >> p.reflect;
+      p.normal = normalize(p.normal);
+      planes.push_back(p);
+    }
+    else if (kind == "light")
+    {
+      Vec3 l;
+      ok = bool(in >> l.x >> l.y >> l.z);
+      lights.push_back(l);
+    }
+    else if (kind == "background")
+    {
+      ok = bool(in >> background.x >> background.y >> background.z);
+    }
+    else if (kind == "output")
+    {
+      ok = bool(in >> output);
+    }
+    else
+    {
+      ok = false;
+    }
+    // leave the current scene alone rather than render half a file
+    if (!ok)
+    {
+      return false;
+    }
+  }
+  m_spheres = std::move(spheres);
+  m_planes = std::move(planes);
+  m_lights = std::move(lights);
+  m_background = background;
+  m_output = output;
+  return true;
+}
+
+void RayTracer::setViewportSize(int _w, int _h)
+{
+  m_width = _w > 0 ? _w : 1;
+  m_height = _h > 0 ? _h : 1;
+}
+
+void RayTracer::setCameraPos(double _x, double _y, double _z)
+{
+  m_eye = {_x, _y, _z};
+}
+
+void RayTracer::setLookAt(double _x, double _y, double _z)
+{
+  m_lookAt = {_x, _y, _z};
+}
+
+void RayTracer::setThreads(size_t _threads)
+{
+  m_threads = _threads;
+  m_pool.reset();
+}
+
+void RayTracer::render()
+{
+  if (!m_pool)
+  {
+    m_pool = std::make_unique<TilePool>(m_threads > 0 ? m_threads : std::thread::hardware_concurrency());
+  }
+  m_forward = normalize(m_lookAt-m_eye);
+  // looking straight up or down needs a different up vector to build the basis
+  Vec3 worldUp = std::abs(m_forward.y) > 0.999 ? Vec3{0.0, 0.0, -1.0} : Vec3{0.0, 1.0, 0.0};
+  m_right = normalize(cross(m_forward, worldUp));
+  m_up = cross(m_right, m_forward);
+  m_pixels.assign(size_t(m_width)*m_height*3, 0);
+  size_t tilesX = (m_width+TileSize-1)/TileSize;
+  size_t tilesY = (m_height+TileSize-1)/TileSize;
+  m_pool->run(tilesX*tilesY, [this](size_t _tile) { renderTile(_tile); });
+  if (!m_output.empty() && !saveImage(m_output))
+  {
+    std::cerr << "RayTracer: could not write " << m_output << "\n";
+  }
+}
+
+void RayTracer::renderTile(size_t _tile)
+{
+  int tilesX = (m_width+TileSize-1)/TileSize;
+  int x0 = static_cast<int>(_tile%tilesX)*TileSize;
+  int y0 = static_cast<int>(_tile/tilesX)*TileSize;
+  int x1 = std::min(x0+TileSize, m_width);
+  int y1 = std::min(y0+TileSize, m_height);
+  double scale = std::tan(FieldOfView*0.5*M_PI/180.0);
+  double aspect = double(m_width)/m_height;
+  double weight = 1.0/(m_samples*m_samples);
+  for (int y=y0; y<y1; ++y)
+  {
+    for (int x=x0; x<x1; ++x)
+    {
+      Vec3 colour{0.0, 0.0, 0.0};
+      for (int sy=0; sy<m_samples; ++sy)
+      {
+        for (int sx=0; sx<m_samples; ++sx)
+        {
+          double u = (2.0*(x+(sx+0.5)/m_samples)/m_width-1.0)*aspect*scale;
+          double v = (1.0-2.0*(y+(sy+0.5)/m_samples)/m_height)*scale;
+          Vec3 dir = normalize(m_forward+m_right*u+m_up*v);
+          colour = colour+trace(m_eye, dir, 0);
+        }
+      }
+      uint8_t *p = &m_pixels[(size_t(y)*m_width+x)*3];
+      p[0] = toByte(colour.x*weight);
+      p[1] = toByte(colour.y*weight);
+      p[2] = toByte(colour.z*weight);
+    }
+  }
+}
+
+bool RayTracer::intersect(const Vec3 &_origin, const Vec3 &_dir, Hit &_hit) const
+{
+  _hit.t = 1e30;
+  bool found = false;
+  for (const auto &s : m_spheres)
+  {
+    Vec3 oc = _origin-s.centre;
+    double b = dot(oc, _dir);
+    double c = dot(oc, oc)-s.radius*s.radius;
+    double disc = b*b-c;
+    if (disc < 0.0)
+    {
+      continue;
+    }
+    double root = std::sqrt(disc);
+    double t = -b-root > Epsilon ? -b-root : -b+root;
+    if (t > Epsilon && t < _hit.t)
+    {
+      _hit.t = t;
+      _hit.point = _origin+_dir*t;
+      _hit.normal = normalize(_hit.point-s.centre);
+      _hit.colour = s.colour;
+      _hit.reflect = s.reflect;
+      found = true;
+    }
+  }
+  for (const auto &p : m_planes)
+  {
+    double denom = dot(p.normal, _dir);
+    if (std::abs(denom) < Epsilon)
+    {
+      continue;
+    }
+    double t = (p.offset-dot(p.normal, _origin))/denom;
+    if (t > Epsilon && t < _hit.t)
+    {
+      _hit.t = t;
+      _hit.point = _origin+_dir*t;
+      _hit.normal = denom < 0.0 ? p.normal : p.normal*-1.0;
+      bool odd = (static_cast<long>(std::floor(_hit.point.x))+static_cast<long>(std::floor(_hit.point.z))) & 1;
+      _hit.colour = odd ? p.colour*0.3 : p.colour;
+      _hit.reflect = p.reflect;
+      found = true;
+    }
+  }
+  return found;
+}
+
+RayTracer::Vec3 RayTracer::trace(const Vec3 &_origin, const Vec3 &_dir, int _depth) const
+{
+  Hit hit;
+  if (!intersect(_origin, _dir, hit))
+  {
+    return m_background;
+  }
+  Vec3 colour = hit.colour*Ambient;
+  // nudge off the surface so the shadow and reflection rays don't hit it again
+  Vec3 start = hit.point+hit.normal*1e-4;
+  for (const auto &light : m_lights)
+  {
+    Vec3 toLight = light-hit.point;
+    double distance = std::sqrt(dot(toLight, toLight));
+    toLight = toLight*(1.0/distance);
+    double diffuse = dot(hit.normal, toLight);
+    if (diffuse <= 0.0)
+    {
+      continue;
+    }
+    Hit blocker;
+    if (intersect(start, toLight, blocker) && blocker.t < distance)
+    {
+      continue;
+    }
+    Vec3 halfway = normalize(toLight-_dir);
+    double specular = std::pow(std::max(dot(hit.normal, halfway), 0.0), 32.0);
+    colour = colour+hit.colour*diffuse+Vec3{1.0, 1.0, 1.0}*(specular*0.5);
+  }
+  if (hit.reflect > 0.0 && _depth < MaxDepth)
+  {
+    Vec3 reflected = _dir-hit.normal*(2.0*dot(_dir, hit.normal));
+    colour = colour*(1.0-hit.reflect)+trace(start, reflected, _depth+1)*hit.reflect;
+  }
+  return colour;
+}
+
+bool RayTracer::saveImage(const std::string &_fname) const
+{
+  if (m_pixels.empty())
+  {
+    return false;
+  }
+  return endsWith(_fname, ".tga") || endsWith(_fname, ".TGA") ? saveTGA(_fname) : savePPM(_fname);
+}
+
+bool RayTracer::savePPM(const std::string &_fname) const
+{
+  std::ofstream file(_fname, std::ios::binary);
+  if (!file)
+  {
+    return false;
+  }
+  file << "P6\n" << m_width << " " << m_height << "\n255\n";
+  file.write(reinterpret_cast<const char *>(m_pixels.data()), static_cast<std::streamsize>(m_pixels.size()));
+  return bool(file);
+}
+
+// uncompressed true colour, top row first, TGA wants BGR
+bool RayTracer::saveTGA(const std::string &_fname) const
+{
+  // the header only has 16 bits for each side
+  if (m_width > 0xffff || m_height > 0xffff)
+  {
+    return false;
+  }
+  std::ofstream file(_fname, std::ios::binary);
+  if (!file)
+  {
+    return false;
+  }
+  uint8_t header[18] = {};
+  header[2] = 2;
+  header[12] = static_cast<uint8_t>(m_width & 0xff);
+  header[13] = static_cast<uint8_t>(m_width >> 8);
+  header[14] = static_cast<uint8_t>(m_height & 0xff);
+  header[15] = static_cast<uint8_t>(m_height >> 8);
+  header[16] = 24;
+  header[17] = 0x20;
+  file.write(reinterpret_cast<const char *>(header), sizeof(header));
+  std::vector<uint8_t> bgr(m_pixels.size());
+  for (size_t i=0; i<m_pixels.size(); i+=3)
+  {
+    bgr[i] = m_pixels[i+2];
+    bgr[i+1] = m_pixels[i+1];
+    bgr[i+2] = m_pixels[i];
+  }
+  file.write(reinterpret_cast<const char *>(bgr.data()), static_cast<std::streamsize>(bgr.size()));
+  return bool(file);
+}
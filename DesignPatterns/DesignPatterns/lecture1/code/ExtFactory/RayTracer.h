@@ -0,0 +1,103 @@
+#ifndef RAYTRACER_H
+#define RAYTRACER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Renderer.h"
+#include "TilePool.h"
+
+///
+/// A CPU ray tracer, spheres and planes lit by point lights with shadows and
+/// reflections. No GPU or window is needed, render() fills a framebuffer in
+/// memory which can then be saved as PPM or TGA. The image is cut into tiles
+/// which a TilePool shares out over every core, tiles are independent so the
+/// speed up is close to the number of cores.
+///
+/// Scene files are plain text, one item per line and # for comments
+///   sphere cx cy cz radius r g b [reflect]
+///   plane nx ny nz offset r g b [reflect]
+///   light x y z
+///   background r g b
+///   output image.tga
+/// colours are 0-1 and planes get a checker pattern. Without a scene file a
+/// small built in scene is rendered.
+class RayTracer : public Renderer
+{
+public:
+  RayTracer();
+  bool loadScene(const std::string &_filename);
+  void setViewportSize(int _w, int _h);
+  void setCameraPos(double _x, double _y, double _z);
+  void setLookAt(double _x, double _y, double _z);
+  void render();
+  void reset();
+  static Renderer *create() { return new RayTracer; }
+
+  /// threads used by render, 0 for one per core
+  void setThreads(size_t _threads);
+  /// rays per pixel along each side, so 2 is 4 rays a pixel
+  void setSamples(int _samples) { m_samples = _samples > 0 ? _samples : 1; }
+  /// render() saves here as well when set, the extension picks PPM or TGA
+  void setOutput(const std::string &_fname) { m_output = _fname; }
+  /// false if the file can't be written or nothing has been rendered, TGA
+  /// also fails for images over 65535 pixels either way
+  bool saveImage(const std::string &_fname) const;
+
+  int width() const { return m_width; }
+  int height() const { return m_height; }
+  /// RGB, 3 bytes a pixel with the top row first
+  const uint8_t *pixels() const { return m_pixels.data(); }
+
+  struct Vec3
+  {
+    double x, y, z;
+  };
+
+private:
+  struct Sphere
+  {
+    Vec3 centre;
+    double radius;
+    Vec3 colour;
+    double reflect;
+  };
+  struct Plane
+  {
+    Vec3 normal;
+    double offset;
+    Vec3 colour;
+    double reflect;
+  };
+  struct Hit;
+  void defaultScene();
+  void renderTile(size_t _tile);
+  bool intersect(const Vec3 &_origin, const Vec3 &_dir, Hit &_hit) const;
+  Vec3 trace(const Vec3 &_origin, const Vec3 &_dir, int _depth) const;
+  bool savePPM(const std::string &_fname) const;
+  bool saveTGA(const std::string &_fname) const;
+
+  std::vector<Sphere> m_spheres;
+  std::vector<Plane> m_planes;
+  std::vector<Vec3> m_lights;
+  Vec3 m_background;
+  Vec3 m_eye;
+  Vec3 m_lookAt;
+  int m_width = 640;
+  int m_height = 480;
+  int m_samples = 1;
+  std::string m_output;
+  std::vector<uint8_t> m_pixels;
+  // made on the first render and dropped by reset so pooled or unused
+  // renderers hold no threads
+  std::unique_ptr<TilePool> m_pool;
+  size_t m_threads = 0;
+  // camera basis for the frame being rendered
+  Vec3 m_forward;
+  Vec3 m_right;
+  Vec3 m_up;
+};
+
+#endif
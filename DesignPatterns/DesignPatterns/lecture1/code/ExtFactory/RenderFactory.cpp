@@ -1,37 +1,151 @@
 #include "RenderFactory.h"
+#include <thread>
 
 // instantiate the static variable in RendererFactory
-std::unordered_map<std::string, std::function<Renderer *()>>  RendererFactory::m_renderers;
-
-void RendererFactory::registerRenderer(const std::string &type,std::function<Renderer *()> cb)
+std::atomic<const RendererFactory::Registry *> RendererFactory::m_registry{nullptr};
+std::unique_ptr<const RendererFactory::Registry> RendererFactory::m_current;
+std::atomic<uint64_t> RendererFactory::m_epoch{0};
+std::array<RendererFactory::ReaderSlot,RendererFactory::ReaderSlots> RendererFactory::m_readers;
+std::atomic<size_t> RendererFactory::m_nextSlot{0};
+std::unordered_map<std::string, size_t> RendererFactory::m_poolCapacity;
+std::mutex RendererFactory::m_writeMutex;
+
+void RendererFactory::update(const std::function<void(Registry &)> &_change)
 {
-  m_renderers[type] = cb;
+  std::lock_guard<std::mutex> lock(m_writeMutex);
+  std::unique_ptr<const Registry> old = std::move(m_current);
+  std::unique_ptr<Registry> next(old != nullptr ? new Registry(*old) : new Registry);
+  _change(*next);
+  m_current = std::move(next);
+  m_registry.store(m_current.get());
+  // readers that start from here on see the new snapshot, wait for the ones
+  // that may still be looking at the old one
+  uint64_t epoch = m_epoch.fetch_add(1);
+  for (auto &slot : m_readers)
+  {
+    while (slot.count[epoch & 1].load() != 0)
+    {
+      std::this_thread::yield();
+    }
+  }
 }
 
-void RendererFactory::unregisterRenderer(const std::string &type)
+RendererFactory::ReaderSlot &RendererFactory::readerSlot()
 {
-  m_renderers.erase(type);
+  thread_local size_t slot = m_nextSlot.fetch_add(1, std::memory_order_relaxed) % ReaderSlots;
+  return m_readers[slot];
 }
 
-Renderer *RendererFactory::createRenderer(const std::string &type)
+RendererFactory::ReadPin::ReadPin()
 {
-
-  auto it = m_renderers.find(type);
-  if (it != m_renderers.end())
+  // check in to the current epoch, if a writer moved it on meanwhile it may
+  // already have stopped waiting for this one so try again
+  ReaderSlot &slot = readerSlot();
+  for (;;)
   {
-    // call the creation callback to construct this derived type
-    return it->second();
+    uint64_t epoch = m_epoch.load();
+    m_count = &slot.count[epoch & 1];
+    m_count->fetch_add(1);
+    if (m_epoch.load() == epoch)
+    {
+      break;
+    }
+    m_count->fetch_sub(1);
   }
-  return nullptr;
 }
 
+RendererFactory::ReadPin::~ReadPin()
+{
+  m_count->fetch_sub(1);
+}
 
+void RendererFactory::retire(const Registry &_registry, const std::string &type)
+{
+  auto it = _registry.find(type);
+  if (it != _registry.end())
+  {
+    // renderers still borrowed from it are deleted when they come back
+    it->second->pool->setCapacity(0);
+  }
+}
 
+void RendererFactory::registerRenderer(const std::string &type,std::function<Renderer *()> cb)
+{
+  update([&](Registry &_registry)
+  {
+    auto capacity = m_poolCapacity.find(type);
+    auto r = std::make_shared<Registration>();
+    r->pool = std::make_shared<RendererPool>(cb, capacity != m_poolCapacity.end() ?
+                                             capacity->second : RendererPool::DefaultCapacity);
+    r->create = std::move(cb);
+    retire(_registry, type);
+    _registry[type] = std::move(r);
+  });
+}
 
+void RendererFactory::unregisterRenderer(const std::string &type)
+{
+  update([&](Registry &_registry)
+  {
+    retire(_registry, type);
+    _registry.erase(type);
+  });
+}
 
+const RendererFactory::Registration *RendererFactory::find(const ReadPin &, const std::string &type)
+{
+  const Registry *registry = m_registry.load();
+  if (registry != nullptr)
+  {
+    auto it = registry->find(type);
+    if (it != registry->end())
+    {
+      return it->second.get();
+    }
+  }
+  return nullptr;
+}
 
+Renderer *RendererFactory::createRenderer(const std::string &type)
+{
+  ReadPin pin;
+  const Registration *r = find(pin, type);
+  if (r != nullptr)
+  {
+    // call the creation callback to construct this derived type
+    return r->create();
+  }
+  return nullptr;
+}
 
+PooledRenderer RendererFactory::acquireRenderer(const std::string &type)
+{
+  ReadPin pin;
+  const Registration *r = find(pin, type);
+  return r != nullptr ? r->pool->acquire() : PooledRenderer();
+}
 
+void RendererFactory::setPoolCapacity(const std::string &type, size_t capacity)
+{
+  std::lock_guard<std::mutex> lock(m_writeMutex);
+  m_poolCapacity[type] = capacity;
+  if (m_current != nullptr)
+  {
+    auto it = m_current->find(type);
+    if (it != m_current->end())
+    {
+      it->second->pool->setCapacity(capacity);
+    }
+  }
+}
 
+Renderer *RendererFactory::createStaticRenderer(std::string_view type)
+{
+  int i = StaticRendererNames.find(type);
+  return i >= 0 ? StaticRenderers[static_cast<size_t>(i)].create() : nullptr;
+}
 
-
+Renderer *RendererFactory::createRenderer(RendererType type)
+{
+  return StaticRenderers[static_cast<size_t>(type)].create();
+}
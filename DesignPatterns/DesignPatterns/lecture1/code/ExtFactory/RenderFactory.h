@@ -1,7 +1,29 @@
+#ifndef RENDERFACTORY_H
+#define RENDERFACTORY_H
 #include "Renderer.h"
+#include "StaticRenderers.h"
+#include "RendererPool.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <functional>
+#include <vector>
+///
+/// The registry can be read from any number of threads while others register
+/// and unregister. Readers use the current snapshot of the registry with no
+/// lock, writers take a mutex, copy the snapshot, change the copy and publish
+/// it with an atomic swap. Readers count themselves in for the epoch they
+/// started in, after publishing a writer moves the epoch on and waits for the
+/// readers of the old one to leave before freeing the old snapshot. The
+/// counts are spread over padded per thread slots so readers on different
+/// threads don't fight over one cache line, and a reader uses the
+/// registration in place for the length of the call with no reference
+/// counting.
 class RendererFactory
 {
 public :
@@ -14,7 +36,66 @@ public :
 
   /// Create an instance of a named 3D renderer
   static Renderer *createRenderer(const std::string &type);
+  /// Borrow a renderer from the pool for this type, it is reset and kept for
+  /// reuse when the handle goes rather than deleted. Empty if not registered.
+  static PooledRenderer acquireRenderer(const std::string &type);
+  /// how many idle renderers of this type are kept, the default is
+  /// RendererPool::DefaultCapacity
+  static void setPoolCapacity(const std::string &type, size_t capacity);
+  /// Create one of the built in renderers, found with a compile time perfect
+  /// hash rather than the registry so registering has no effect on these
+  static Renderer *createStaticRenderer(std::string_view type);
+  /// when the backend is known up front there is no lookup at all
+  static Renderer *createRenderer(RendererType type);
+  template <RendererType Type>
+  static Renderer *createRenderer() { return StaticRenderers[static_cast<size_t>(Type)].create(); }
 private :
-    static std::unordered_map<std::string, std::function<Renderer *()>> m_renderers;
+    // never changed once published
+    struct Registration
+    {
+      std::function<Renderer *()> create;
+      // a new pool for every registration so renderers made by an old
+      // callback are never handed out for the new one
+      std::shared_ptr<RendererPool> pool;
+    };
+    using Registry = std::unordered_map<std::string, std::shared_ptr<const Registration>>;
+    // a reader's place in the current epoch, the published snapshot and
+    // everything in it stay alive until the pin goes
+    class ReadPin
+    {
+    public:
+      ReadPin();
+      ~ReadPin();
+      ReadPin(const ReadPin &)=delete;
+      ReadPin &operator=(const ReadPin &)=delete;
+    private:
+      std::atomic<size_t> *m_count;
+    };
+    // null if not registered, only valid while _pin is held
+    static const Registration *find(const ReadPin &_pin, const std::string &type);
+    // copy the current registry, let _change edit the copy, publish it and
+    // free the old one once no reader can still see it
+    static void update(const std::function<void(Registry &)> &_change);
+    // stop keeping idle renderers for a registration that is going
+    static void retire(const Registry &_registry, const std::string &type);
+    // the published snapshot, m_current owns it and is only touched under
+    // m_writeMutex
+    static std::atomic<const Registry *> m_registry;
+    static std::unique_ptr<const Registry> m_current;
+    // readers in the current and the previous epoch, indexed by epoch&1.
+    // Each thread is given a slot the first time it reads, threads only share
+    // a slot once there are more than ReaderSlots of them.
+    struct alignas(64) ReaderSlot
+    {
+      std::array<std::atomic<size_t>,2> count{};
+    };
+    static constexpr size_t ReaderSlots = 64;
+    static std::atomic<uint64_t> m_epoch;
+    static std::array<ReaderSlot,ReaderSlots> m_readers;
+    static std::atomic<size_t> m_nextSlot;
+    static ReaderSlot &readerSlot();
+    static std::unordered_map<std::string, size_t> m_poolCapacity;
+    static std::mutex m_writeMutex;
 
 };
+#endif
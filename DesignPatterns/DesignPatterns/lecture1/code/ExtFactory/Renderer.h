@@ -2,6 +2,7 @@
 #define RENDERER_H
 
 #include <string>
+#include "CommandBuffer.h"
 
 ///
 /// An abstract interface for a 3D renderer based on the martin reddy book
@@ -15,6 +16,17 @@ public:
   virtual void setCameraPos(double x, double y, double z) = 0;
   virtual void setLookAt(double x, double y, double z) = 0;
   virtual void render() = 0;
+  /// put the renderer back to how it was when made so a pool can hand it out
+  /// again, backends holding scene or camera state should override this
+  virtual void reset() {}
+  /// run a recorded buffer, by default each command goes to the matching call
+  /// above but a backend can override this to handle the buffer as a whole
+  virtual void execute(const CommandBuffer &_commands);
 };
 
+inline void Renderer::execute(const CommandBuffer &_commands)
+{
+  _commands.replay(*this);
+}
+
 #endif
@@ -0,0 +1,99 @@
+#include "RendererPool.h"
+
+PooledRenderer &PooledRenderer::operator=(PooledRenderer &&_other) noexcept
+{
+  if (this != &_other)
+  {
+    release();
+    m_renderer = _other.m_renderer;
+    m_pool = std::move(_other.m_pool);
+    _other.m_renderer = nullptr;
+  }
+  return *this;
+}
+
+void PooledRenderer::release()
+{
+  if (m_renderer != nullptr)
+  {
+    m_pool->recycle(m_renderer);
+    m_renderer = nullptr;
+  }
+  m_pool.reset();
+}
+
+RendererPool::RendererPool(std::function<Renderer *()> _create, size_t _capacity) :
+  m_create(std::move(_create)), m_capacity(_capacity)
+{
+}
+
+RendererPool::~RendererPool()
+{
+  for (auto r : m_idle)
+  {
+    delete r;
+  }
+}
+
+PooledRenderer RendererPool::acquire()
+{
+  Renderer *r = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_idle.empty())
+    {
+      r = m_idle.back();
+      m_idle.pop_back();
+    }
+  }
+  // make a new one outside the lock, it is the slow part
+  if (r == nullptr)
+  {
+    r = m_create();
+  }
+  return r != nullptr ? PooledRenderer(r, shared_from_this()) : PooledRenderer();
+}
+
+void RendererPool::recycle(Renderer *_renderer)
+{
+  _renderer->reset();
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_idle.size() < m_capacity)
+    {
+      m_idle.push_back(_renderer);
+      return;
+    }
+  }
+  delete _renderer;
+}
+
+void RendererPool::setCapacity(size_t _capacity)
+{
+  std::vector<Renderer *> extra;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_capacity = _capacity;
+    while (m_idle.size() > m_capacity)
+    {
+      extra.push_back(m_idle.back());
+      m_idle.pop_back();
+    }
+  }
+  for (auto r : extra)
+  {
+    delete r;
+  }
+}
+
+size_t RendererPool::capacity() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_capacity;
+}
+
+size_t RendererPool::idle() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_idle.size();
+}
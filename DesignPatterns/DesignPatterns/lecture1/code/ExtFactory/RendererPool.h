@@ -0,0 +1,72 @@
+#ifndef RENDERERPOOL_H
+#define RENDERERPOOL_H
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "Renderer.h"
+
+class RendererPool;
+
+///
+/// Owns a renderer borrowed from a RendererPool and gives it back (reset
+/// rather than destroyed) when it goes out of scope. Move only.
+class PooledRenderer
+{
+public:
+  PooledRenderer()=default;
+  PooledRenderer(Renderer *_renderer, std::shared_ptr<RendererPool> _pool) :
+    m_renderer(_renderer), m_pool(std::move(_pool)) {}
+  ~PooledRenderer() { release(); }
+  PooledRenderer(PooledRenderer &&_other) noexcept :
+    m_renderer(_other.m_renderer), m_pool(std::move(_other.m_pool)) { _other.m_renderer = nullptr; }
+  PooledRenderer &operator=(PooledRenderer &&_other) noexcept;
+  PooledRenderer(const PooledRenderer &)=delete;
+  PooledRenderer &operator=(const PooledRenderer &)=delete;
+
+  Renderer *get() const { return m_renderer; }
+  Renderer *operator->() const { return m_renderer; }
+  Renderer &operator*() const { return *m_renderer; }
+  explicit operator bool() const { return m_renderer != nullptr; }
+  /// hand the renderer back now rather than at the end of the scope
+  void release();
+
+private:
+  Renderer *m_renderer = nullptr;
+  // kept alive by the handle so the pool can go from the factory first
+  std::shared_ptr<RendererPool> m_pool;
+};
+
+///
+/// Idle renderers of one backend kept for reuse. Creating a real backend is
+/// expensive so up to capacity() returned renderers are reset and kept rather
+/// than deleted. Safe to use from any thread.
+class RendererPool : public std::enable_shared_from_this<RendererPool>
+{
+public:
+  static constexpr size_t DefaultCapacity = 4;
+  explicit RendererPool(std::function<Renderer *()> _create, size_t _capacity=DefaultCapacity);
+  ~RendererPool();
+  RendererPool(const RendererPool &)=delete;
+  RendererPool &operator=(const RendererPool &)=delete;
+
+  /// an idle renderer if there is one otherwise a new one, the handle is
+  /// empty if the backend can't make one
+  PooledRenderer acquire();
+  /// called by PooledRenderer
+  void recycle(Renderer *_renderer);
+  /// shrinking deletes any idle renderers over the new capacity
+  void setCapacity(size_t _capacity);
+  size_t capacity() const;
+  size_t idle() const;
+
+private:
+  std::function<Renderer *()> m_create;
+  mutable std::mutex m_mutex;
+  std::vector<Renderer *> m_idle;
+  size_t m_capacity;
+};
+
+#endif
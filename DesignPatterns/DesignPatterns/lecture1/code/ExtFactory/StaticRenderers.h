@@ -0,0 +1,45 @@
+#ifndef STATICRENDERERS_H
+#define STATICRENDERERS_H
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+#include "PerfectHash.h"
+#include "OpenGLRenderer.h"
+#include "DirectXRenderer.h"
+#include "GLES.h"
+
+///
+/// The backends built into the program, known at compile time so they can be
+/// created through plain function pointers with no map or std::function.
+enum class RendererType { OpenGL, DirectX, GLES };
+
+struct StaticRenderer
+{
+  std::string_view name;
+  Renderer *(*create)();
+};
+
+/// indexed by RendererType so keep the two in the same order
+inline constexpr std::array<StaticRenderer,3> StaticRenderers =
+{{
+  {"opengl", OpenGLRenderer::create},
+  {"DirectX", DirectXRenderer::create},
+  {"GLES", GLES::create}
+}};
+
+inline constexpr PerfectHash<StaticRenderers.size()> StaticRendererNames(
+  [] {
+    std::array<std::string_view,StaticRenderers.size()> names{};
+    for (size_t i=0; i<names.size(); ++i)
+    {
+      names[i] = StaticRenderers[i].name;
+    }
+    return names;
+  }());
+
+static_assert(StaticRendererNames.find("opengl") == static_cast<int>(RendererType::OpenGL), "StaticRenderers out of order");
+static_assert(StaticRendererNames.find("DirectX") == static_cast<int>(RendererType::DirectX), "StaticRenderers out of order");
+static_assert(StaticRendererNames.find("GLES") == static_cast<int>(RendererType::GLES), "StaticRenderers out of order");
+
+#endif
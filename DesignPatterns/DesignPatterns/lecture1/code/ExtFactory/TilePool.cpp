@@ -0,0 +1,124 @@
+#include "TilePool.h"
+
+TilePool::TilePool(size_t _threads)
+{
+  if (_threads == 0)
+  {
+    _threads = 1;
+  }
+  for (size_t i=0; i<_threads; ++i)
+  {
+    m_queues.push_back(std::make_unique<Queue>());
+  }
+  // queue 0 belongs to the thread calling run
+  for (size_t i=1; i<_threads; ++i)
+  {
+    m_threads.emplace_back(&TilePool::worker, this, i);
+  }
+}
+
+TilePool::~TilePool()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_quit = true;
+  }
+  m_wake.notify_all();
+  for (auto &t : m_threads)
+  {
+    t.join();
+  }
+}
+
+void TilePool::run(size_t _tiles, const std::function<void(size_t)> &_f)
+{
+  if (_tiles == 0)
+  {
+    return;
+  }
+  // hand out contiguous runs so neighbouring tiles stay on one thread until
+  // someone has to steal
+  size_t threads = m_queues.size();
+  for (size_t i=0; i<threads; ++i)
+  {
+    std::lock_guard<std::mutex> lock(m_queues[i]->mutex);
+    for (size_t t=_tiles*i/threads; t<_tiles*(i+1)/threads; ++t)
+    {
+      m_queues[i]->tiles.push_back(t);
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_job = &_f;
+    m_pending = m_threads.size();
+    ++m_generation;
+  }
+  m_wake.notify_all();
+  runTiles(0);
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_done.wait(lock, [this]{ return m_pending == 0; });
+  m_job = nullptr;
+}
+
+bool TilePool::pop(size_t _index, size_t &_tile)
+{
+  Queue &q = *m_queues[_index];
+  std::lock_guard<std::mutex> lock(q.mutex);
+  if (q.tiles.empty())
+  {
+    return false;
+  }
+  _tile = q.tiles.front();
+  q.tiles.pop_front();
+  return true;
+}
+
+// take from the far end of someone else's run, furthest from what they are
+// working on now
+bool TilePool::steal(size_t _index, size_t &_tile)
+{
+  for (size_t i=1; i<m_queues.size(); ++i)
+  {
+    Queue &q = *m_queues[(_index+i)%m_queues.size()];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (!q.tiles.empty())
+    {
+      _tile = q.tiles.back();
+      q.tiles.pop_back();
+      return true;
+    }
+  }
+  return false;
+}
+
+void TilePool::runTiles(size_t _index)
+{
+  size_t tile;
+  while (pop(_index, tile) || steal(_index, tile))
+  {
+    (*m_job)(tile);
+  }
+}
+
+void TilePool::worker(size_t _index)
+{
+  uint64_t seen = 0;
+  for (;;)
+  {
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_wake.wait(lock, [&]{ return m_quit || m_generation != seen; });
+      if (m_quit)
+      {
+        return;
+      }
+      seen = m_generation;
+    }
+    runTiles(_index);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (--m_pending == 0)
+    {
+      m_done.notify_one();
+    }
+  }
+}
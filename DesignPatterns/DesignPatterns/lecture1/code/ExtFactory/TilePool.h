@@ -0,0 +1,58 @@
+#ifndef TILEPOOL_H
+#define TILEPOOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+///
+/// A fixed set of threads that work through a batch of tiles. Every thread
+/// starts with its own run of tiles, taking them from the front of its queue,
+/// and once that is empty it steals from the back of another thread's queue,
+/// so a thread that got the cheap part of the image helps with the expensive
+/// part rather than sitting idle. Tiles never move back so a thread is done
+/// when it finds every queue empty.
+class TilePool
+{
+public:
+  /// _threads is the total including the thread calling run
+  explicit TilePool(size_t _threads=std::thread::hardware_concurrency());
+  ~TilePool();
+  TilePool(const TilePool &)=delete;
+  TilePool &operator=(const TilePool &)=delete;
+
+  size_t size() const { return m_queues.size(); }
+  /// calls _f(tile) for each tile in [0,_tiles) and returns once they have all
+  /// finished, tiles run on any thread so _f must only touch its own tile.
+  /// Only one run may be going at a time.
+  void run(size_t _tiles, const std::function<void(size_t)> &_f);
+
+private:
+  struct Queue
+  {
+    std::mutex mutex;
+    std::deque<size_t> tiles;
+  };
+  void worker(size_t _index);
+  void runTiles(size_t _index);
+  bool pop(size_t _index, size_t &_tile);
+  bool steal(size_t _index, size_t &_tile);
+  std::vector<std::unique_ptr<Queue>> m_queues;
+  std::vector<std::thread> m_threads;
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::condition_variable m_done;
+  // the current job, only written under m_mutex while no workers are running it
+  const std::function<void(size_t)> *m_job = nullptr;
+  size_t m_pending = 0;
+  uint64_t m_generation = 0;
+  bool m_quit = false;
+};
+
+#endif
@@ -1,15 +1,57 @@
+#include <cstdlib>
 #include <iostream>
+#include <sstream>
+#include <thread>
 #include "RenderFactory.h"
 #include "OpenGLRenderer.h"
 #include "DirectXRenderer.h"
 #include "GLES.h"
+#include "RayTracer.h"
+
+// a backend's own execute has to make the same calls the generic one does,
+// run the buffer both ways and compare what the backend printed
+template <typename Backend>
+static bool executeMatchesDefault(const CommandBuffer &_commands)
+{
+  std::ostringstream own;
+  std::ostringstream generic;
+  std::ostringstream quiet;
+  std::streambuf *out = std::cout.rdbuf(own.rdbuf());
+  {
+    Backend r;
+    r.execute(_commands);
+    std::cout.rdbuf(generic.rdbuf());
+    r.Renderer::execute(_commands);
+    // keep the destructor's message out of the demo
+    std::cout.rdbuf(quiet.rdbuf());
+  }
+  std::cout.rdbuf(out);
+  return own.str() == generic.str() && !own.str().empty();
+}
 
 int main()
 {
+  CommandBuffer check;
+  check.loadScene("check.scene");
+  for (int i=0; i<3; ++i)
+  {
+    check.setViewportSize(320*(i+1), 240*(i+1));
+    check.setCameraPos(i, 0, 10);
+    check.setLookAt(0, 0, 0);
+    check.render();
+  }
+  if (!executeMatchesDefault<OpenGLRenderer>(check) ||
+      !executeMatchesDefault<DirectXRenderer>(check) ||
+      !executeMatchesDefault<GLES>(check))
+  {
+    std::cerr<<"a backend's execute doesn't match Renderer::execute\n";
+    return EXIT_FAILURE;
+  }
   // register the various 3D renderers with the factory object
   RendererFactory::registerRenderer("opengl", OpenGLRenderer::create);
   RendererFactory::registerRenderer("DirectX", DirectXRenderer::create);
   RendererFactory::registerRenderer("GLES", GLES::create);
+  RendererFactory::registerRenderer("raytracer", RayTracer::create);
   // create an OpenGL renderer
   Renderer *ogl = RendererFactory::createRenderer("opengl");
   ogl->render();
@@ -24,6 +66,14 @@ int main()
   Renderer *gles = RendererFactory::createRenderer("GLES");
   gles->render();
   delete gles;
+  // short lived renderers can come from a pool instead, at most two idle
+  // OpenGL renderers are kept
+  RendererFactory::setPoolCapacity("opengl", 2);
+  for (int frame=0; frame<3; ++frame)
+  {
+    PooledRenderer offscreen = RendererFactory::acquireRenderer("opengl");
+    offscreen->render();
+  } // handed back (and reset) here, the next frame gets the same one
   // unregister the DirectX renderer
   RendererFactory::unregisterRenderer("DirectX");
   DirectX = RendererFactory::createRenderer("DirectX");
@@ -31,6 +81,49 @@ int main()
   {
     std::cout << "DirectX renderer unregistered" << std::endl;
   }
+  // frames can be recorded on worker threads, one buffer each, then run with
+  // a single call per buffer
+  CommandBuffer views[2];
+  std::thread recorders[2];
+  for (int i=0; i<2; ++i)
+  {
+    recorders[i] = std::thread([&views, i]
+    {
+      views[i].setViewportSize(640, 480);
+      views[i].setCameraPos(0, 2, 10*(i+1));
+      views[i].setLookAt(0, 0, 0);
+      views[i].render();
+    });
+  }
+  for (auto &t : recorders)
+  {
+    t.join();
+  }
+  PooledRenderer batched = RendererFactory::acquireRenderer("opengl");
+  for (auto &v : views)
+  {
+    batched->execute(v);
+  }
+  batched.release();
+  // the built in backends can skip the registry altogether
+  Renderer *builtin = RendererFactory::createStaticRenderer("DirectX");
+  builtin->render();
+  delete builtin;
+  builtin = RendererFactory::createRenderer<RendererType::GLES>();
+  builtin->render();
+  delete builtin;
+  // the ray tracer needs no GPU, the scene file says where the image goes
+  Renderer *raytracer = RendererFactory::createRenderer("raytracer");
+  if (!raytracer->loadScene("demo.scene"))
+  {
+    std::cout << "no demo.scene, rendering the built in scene" << std::endl;
+    static_cast<RayTracer *>(raytracer)->setOutput("raytracer.tga");
+  }
+  raytracer->setViewportSize(800, 600);
+  raytracer->setCameraPos(0, 2, 8);
+  raytracer->setLookAt(0, 1, 0);
+  raytracer->render();
+  delete raytracer;
   return EXIT_SUCCESS;
 }
 
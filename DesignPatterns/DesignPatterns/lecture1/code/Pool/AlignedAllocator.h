@@ -0,0 +1,41 @@
+// minimal allocator so std::vector storage can start on a cache line boundary
+#ifndef ALIGNEDALLOCATOR_H_
+#define ALIGNEDALLOCATOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+constexpr size_t CacheLineSize = 64;
+
+template <typename T, size_t Align=CacheLineSize>
+class AlignedAllocator
+{
+public:
+  using value_type = T;
+  template <typename U> struct rebind { using other = AlignedAllocator<U,Align>; };
+
+  AlignedAllocator()=default;
+  template <typename U>
+  AlignedAllocator(const AlignedAllocator<U,Align> &) {}
+
+  T *allocate(size_t _n)
+  {
+    // over allocate and keep the real pointer just in front of the aligned block
+    void *raw = ::operator new(_n*sizeof(T)+Align+sizeof(void *));
+    uintptr_t aligned = (reinterpret_cast<uintptr_t>(raw)+sizeof(void *)+Align-1) & ~static_cast<uintptr_t>(Align-1);
+    reinterpret_cast<void **>(aligned)[-1] = raw;
+    return reinterpret_cast<T *>(aligned);
+  }
+  void deallocate(T *_p, size_t)
+  {
+    ::operator delete(reinterpret_cast<void **>(_p)[-1]);
+  }
+};
+
+template <typename T, typename U, size_t Align>
+bool operator==(const AlignedAllocator<T,Align> &, const AlignedAllocator<U,Align> &) { return true; }
+template <typename T, typename U, size_t Align>
+bool operator!=(const AlignedAllocator<T,Align> &, const AlignedAllocator<U,Align> &) { return false; }
+
+#endif
@@ -0,0 +1,67 @@
+#include "Emitter.h"
+
+void SpawnBatch::resize(size_t _n)
+{
+  x.resize(_n);
+  y.resize(_n);
+  xVel.resize(_n);
+  yVel.resize(_n);
+  lifetime.resize(_n);
+}
+
+void SpawnBatch::add(double _x, double _y, double _xVel, double _yVel, int _lifetime)
+{
+  x.push_back(_x);
+  y.push_back(_y);
+  xVel.push_back(_xVel);
+  yVel.push_back(_yVel);
+  lifetime.push_back(_lifetime);
+}
+
+Emitter::Emitter(double _x, double _y, double _xVel, double _yVel, size_t _rate) :
+  m_x(_x), m_y(_y), m_xVel(_xVel), m_yVel(_yVel), m_rate(_rate)
+{
+}
+
+void Emitter::setLifetime(int _min, int _max)
+{
+  m_minLifetime = _min;
+  m_maxLifetime = _max < _min ? _min : _max;
+}
+
+// counter based hash rather than a stateful generator so each element only
+// depends on its index and the loop has no carried dependency
+static inline uint32_t hash(uint32_t _v)
+{
+  _v ^= _v >> 16;
+  _v *= 0x7feb352du;
+  _v ^= _v >> 15;
+  _v *= 0x846ca68bu;
+  _v ^= _v >> 16;
+  return _v;
+}
+
+void Emitter::generate(size_t _count, SpawnBatch &_batch)
+{
+  _batch.resize(_count);
+  double *x = _batch.x.data();
+  double *y = _batch.y.data();
+  double *xVel = _batch.xVel.data();
+  double *yVel = _batch.yVel.data();
+  int *lifetime = _batch.lifetime.data();
+  const uint64_t range = static_cast<uint64_t>(m_maxLifetime-m_minLifetime)+1;
+  // maps the top 24 bits of a hash to [-1,1)
+  const double scale = 2.0/16777216.0;
+  for (size_t i=0; i<_count; ++i)
+  {
+    uint32_t h1 = hash(m_seed+static_cast<uint32_t>(i)*3);
+    uint32_t h2 = hash(m_seed+static_cast<uint32_t>(i)*3+1);
+    uint32_t h3 = hash(m_seed+static_cast<uint32_t>(i)*3+2);
+    x[i] = m_x;
+    y[i] = m_y;
+    xVel[i] = m_xVel+m_spread*((h1>>8)*scale-1.0);
+    yVel[i] = m_yVel+m_spread*((h2>>8)*scale-1.0);
+    lifetime[i] = m_minLifetime+static_cast<int>((h3*range)>>32);
+  }
+  m_seed += static_cast<uint32_t>(_count)*3;
+}
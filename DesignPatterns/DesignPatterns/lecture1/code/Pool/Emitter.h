@@ -0,0 +1,45 @@
+// describes how to spawn a burst of particles, the start values are generated
+// a whole batch at a time into separate arrays so the loop can vectorize
+#ifndef EMITTER_H_
+#define EMITTER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct SpawnBatch
+{
+  void resize(size_t _n);
+  void add(double _x, double _y, double _xVel, double _yVel, int _lifetime);
+  void clear() { resize(0); }
+  size_t size() const { return lifetime.size(); }
+  std::vector<double> x, y;
+  std::vector<double> xVel, yVel;
+  std::vector<int> lifetime;
+};
+
+class Emitter
+{
+public:
+  Emitter(double _x, double _y, double _xVel, double _yVel, size_t _rate=100);
+  void setPosition(double _x, double _y) { m_x=_x; m_y=_y; }
+  // each velocity component is jittered by up to +/- _spread
+  void setSpread(double _spread) { m_spread=_spread; }
+  // lifetimes are picked from [_min,_max]
+  void setLifetime(int _min, int _max);
+  void setRate(size_t _rate) { m_rate=_rate; }
+  size_t rate() const { return m_rate; }
+  // fill _batch with the start values for _count particles
+  void generate(size_t _count, SpawnBatch &_batch);
+private:
+  double m_x, m_y;
+  double m_xVel, m_yVel;
+  double m_spread=0.0;
+  int m_minLifetime=10;
+  int m_maxLifetime=10;
+  size_t m_rate;
+  // advanced every batch so consecutive bursts differ
+  uint32_t m_seed=0;
+};
+
+#endif
@@ -0,0 +1,40 @@
+// 16.16 fixed point number, enough for the handful of operations the
+// particles need so they can be stored in 32 bits without using float
+#ifndef FIXED16_H_
+#define FIXED16_H_
+
+#include <cmath>
+#include <cstdint>
+
+class Fixed16
+{
+public:
+  // left uninitialised like the built in types so Fixed16 can live in a union
+  Fixed16()=default;
+  Fixed16(double _v) : m_value(static_cast<int32_t>(std::lround(_v*One))) {}
+  explicit operator double() const { return m_value/static_cast<double>(One); }
+  explicit operator float() const { return m_value/static_cast<float>(One); }
+
+  static Fixed16 fromRaw(int32_t _raw) { Fixed16 f; f.m_value=_raw; return f; }
+  int32_t raw() const { return m_value; }
+
+  Fixed16 &operator+=(Fixed16 _rhs) { m_value += _rhs.m_value; return *this; }
+  Fixed16 &operator-=(Fixed16 _rhs) { m_value -= _rhs.m_value; return *this; }
+  Fixed16 &operator*=(Fixed16 _rhs)
+  {
+    m_value = static_cast<int32_t>((static_cast<int64_t>(m_value)*_rhs.m_value) >> 16);
+    return *this;
+  }
+  friend Fixed16 operator+(Fixed16 _a, Fixed16 _b) { return _a += _b; }
+  friend Fixed16 operator-(Fixed16 _a, Fixed16 _b) { return _a -= _b; }
+  friend Fixed16 operator*(Fixed16 _a, Fixed16 _b) { return _a *= _b; }
+  friend bool operator==(Fixed16 _a, Fixed16 _b) { return _a.m_value == _b.m_value; }
+  friend bool operator!=(Fixed16 _a, Fixed16 _b) { return _a.m_value != _b.m_value; }
+  friend bool operator<(Fixed16 _a, Fixed16 _b) { return _a.m_value < _b.m_value; }
+
+private:
+  static constexpr int32_t One = 1<<16;
+  int32_t m_value;
+};
+
+#endif
@@ -0,0 +1,263 @@
+#include "FrameStream.h"
+#include <cstring>
+#if defined(__unix__) || defined(__APPLE__)
+  #define FRAMESTREAM_MMAP
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <unistd.h>
+#endif
+
+namespace
+{
+  constexpr size_t BufferSize = 1<<20;
+  constexpr size_t MapGrowSize = 64<<20;
+}
+
+FrameWriter::FrameWriter(const std::string &_fname, Mode _mode) : m_mode(_mode)
+{
+#ifdef FRAMESTREAM_MMAP
+  if (m_mode == Mode::MemoryMapped)
+  {
+    m_fd = ::open(_fname.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (m_fd < 0)
+    {
+      return;
+    }
+  }
+#else
+  m_mode = Mode::Buffered;
+#endif
+  if (m_mode == Mode::Buffered)
+  {
+    m_file = std::fopen(_fname.c_str(), "wb");
+    if (m_file == nullptr)
+    {
+      return;
+    }
+    m_buffer.resize(BufferSize);
+  }
+  write(FrameMagic, sizeof(FrameMagic));
+  write(&FrameVersion, sizeof(FrameVersion));
+}
+
+FrameWriter::~FrameWriter()
+{
+  close();
+}
+
+bool FrameWriter::isOpen() const
+{
+  return m_file != nullptr || m_fd >= 0;
+}
+
+bool FrameWriter::writeFrame(uint32_t _frame, const double *_xy, uint32_t _count)
+{
+  if (!isOpen() || m_failed)
+  {
+    return false;
+  }
+  size_t bytes = sizeof(double)*2*_count;
+  // grow the mapping for the whole record first so a failure can't leave
+  // half of one in the file
+  if (m_mode == Mode::MemoryMapped && !reserve(sizeof(_frame)+sizeof(_count)+bytes))
+  {
+    m_failed = true;
+    return false;
+  }
+  write(&_frame, sizeof(_frame));
+  write(&_count, sizeof(_count));
+  write(_xy, bytes);
+  return !m_failed;
+}
+
+void FrameWriter::write(const void *_data, size_t _size)
+{
+  if (m_failed)
+  {
+    return;
+  }
+  if (m_mode == Mode::MemoryMapped)
+  {
+    if (!reserve(_size))
+    {
+      m_failed = true;
+      return;
+    }
+    std::memcpy(m_map+m_used, _data, _size);
+    m_used += _size;
+    return;
+  }
+  // big records go straight out rather than through the buffer
+  if (m_used+_size > m_buffer.size())
+  {
+    flush();
+    if (_size > m_buffer.size())
+    {
+      if (!m_failed && std::fwrite(_data, 1, _size, m_file) != _size)
+      {
+        m_failed = true;
+      }
+      return;
+    }
+  }
+  std::memcpy(m_buffer.data()+m_used, _data, _size);
+  m_used += _size;
+}
+
+void FrameWriter::flush()
+{
+  if (m_file != nullptr && m_used > 0)
+  {
+    if (!m_failed && std::fwrite(m_buffer.data(), 1, m_used, m_file) != m_used)
+    {
+      m_failed = true;
+    }
+    m_used = 0;
+  }
+}
+
+// grow the file and the mapping so another _size bytes fit
+bool FrameWriter::reserve(size_t _size)
+{
+#ifdef FRAMESTREAM_MMAP
+  if (m_used+_size <= m_mapSize)
+  {
+    return true;
+  }
+  size_t newSize = m_mapSize;
+  while (newSize < m_used+_size)
+  {
+    newSize += MapGrowSize;
+  }
+  if (m_map != nullptr)
+  {
+    ::munmap(m_map, m_mapSize);
+    m_map = nullptr;
+    m_mapSize = 0;
+  }
+  if (::ftruncate(m_fd, static_cast<off_t>(newSize)) != 0)
+  {
+    return false;
+  }
+  void *map = ::mmap(nullptr, newSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+  if (map == MAP_FAILED)
+  {
+    return false;
+  }
+  m_map = static_cast<char *>(map);
+  m_mapSize = newSize;
+  return true;
+#else
+  (void)_size;
+  return false;
+#endif
+}
+
+bool FrameWriter::close()
+{
+  bool wasOpen = isOpen();
+#ifdef FRAMESTREAM_MMAP
+  if (m_fd >= 0)
+  {
+    if (m_map != nullptr)
+    {
+      ::munmap(m_map, m_mapSize);
+      m_map = nullptr;
+    }
+    // drop the unused tail of the last growth step
+    if (::ftruncate(m_fd, static_cast<off_t>(m_used)) != 0)
+    {
+      m_failed = true;
+    }
+    if (::close(m_fd) != 0)
+    {
+      m_failed = true;
+    }
+    m_fd = -1;
+  }
+#endif
+  if (m_file != nullptr)
+  {
+    flush();
+    if (std::fclose(m_file) != 0)
+    {
+      m_failed = true;
+    }
+    m_file = nullptr;
+  }
+  return wasOpen && !m_failed;
+}
+
+FrameReader::FrameReader(const std::string &_fname)
+{
+  m_file = std::fopen(_fname.c_str(), "rb");
+  if (m_file == nullptr)
+  {
+    return;
+  }
+  char magic[4];
+  uint32_t version;
+  if (std::fread(magic, sizeof(magic), 1, m_file) != 1 ||
+      std::memcmp(magic, FrameMagic, sizeof(magic)) != 0 ||
+      std::fread(&version, sizeof(version), 1, m_file) != 1 ||
+      version != FrameVersion)
+  {
+    std::fclose(m_file);
+    m_file = nullptr;
+    return;
+  }
+  // the size bounds how big a record can claim to be
+  long start = std::ftell(m_file);
+  if (start < 0 || std::fseek(m_file, 0, SEEK_END) != 0)
+  {
+    m_failed = true;
+    return;
+  }
+  long end = std::ftell(m_file);
+  m_remaining = end > start ? static_cast<uint64_t>(end-start) : 0;
+  if (end < 0 || std::fseek(m_file, start, SEEK_SET) != 0)
+  {
+    m_failed = true;
+  }
+}
+
+FrameReader::~FrameReader()
+{
+  if (m_file != nullptr)
+  {
+    std::fclose(m_file);
+  }
+}
+
+bool FrameReader::next(uint32_t &_frame, std::vector<double> &_xy)
+{
+  if (m_file == nullptr || m_failed || m_remaining == 0)
+  {
+    return false;
+  }
+  uint32_t count;
+  uint64_t header = sizeof(_frame)+sizeof(count);
+  if (m_remaining < header ||
+      std::fread(&_frame, sizeof(_frame), 1, m_file) != 1 ||
+      std::fread(&count, sizeof(count), 1, m_file) != 1)
+  {
+    m_failed = true;
+    return false;
+  }
+  m_remaining -= header;
+  // a corrupt count mustn't get to allocate more than the file could hold
+  uint64_t bytes = sizeof(double)*2*uint64_t(count);
+  if (bytes > m_remaining)
+  {
+    m_failed = true;
+    return false;
+  }
+  _xy.resize(2*size_t(count));
+  if (std::fread(_xy.data(), sizeof(double), _xy.size(), m_file) != _xy.size())
+  {
+    m_failed = true;
+    return false;
+  }
+  m_remaining -= bytes;
+  return true;
+}
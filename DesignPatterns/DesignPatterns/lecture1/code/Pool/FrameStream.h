@@ -0,0 +1,73 @@
+// binary export of particle positions, one packed record per frame
+// file layout (native byte order)
+//   header : char magic[4] = "PFRM", uint32 version
+//   record : uint32 frame, uint32 count, count * { double x, double y }
+#ifndef FRAMESTREAM_H_
+#define FRAMESTREAM_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+class FrameWriter
+{
+public:
+  enum class Mode { Buffered, MemoryMapped };
+  // MemoryMapped falls back to Buffered where mmap is not available
+  explicit FrameWriter(const std::string &_fname, Mode _mode=Mode::Buffered);
+  ~FrameWriter();
+  FrameWriter(const FrameWriter &)=delete;
+  FrameWriter &operator=(const FrameWriter &)=delete;
+
+  bool isOpen() const;
+  // false once a write has failed, nothing is written after that so the file
+  // ends at or part way through the failed record, which FrameReader treats
+  // as the end of the stream
+  bool good() const { return !m_failed; }
+  // _xy holds _count interleaved x,y pairs, false if the record was not written
+  bool writeFrame(uint32_t _frame, const double *_xy, uint32_t _count);
+  // false if any write failed or the file could not be finished off
+  bool close();
+
+private:
+  void write(const void *_data, size_t _size);
+  void flush();
+  bool reserve(size_t _size);
+  Mode m_mode;
+  FILE *m_file = nullptr;
+  std::vector<char> m_buffer;
+  size_t m_used = 0;
+  bool m_failed = false;
+  // mapped mode
+  int m_fd = -1;
+  char *m_map = nullptr;
+  size_t m_mapSize = 0;
+};
+
+class FrameReader
+{
+public:
+  explicit FrameReader(const std::string &_fname);
+  ~FrameReader();
+  FrameReader(const FrameReader &)=delete;
+  FrameReader &operator=(const FrameReader &)=delete;
+
+  bool isOpen() const { return m_file != nullptr; }
+  // false once a record was truncated or claimed more particles than the rest
+  // of the file holds, next returns false from then on
+  bool good() const { return !m_failed; }
+  // returns false at the end of the file or on a bad record (see good)
+  bool next(uint32_t &_frame, std::vector<double> &_xy);
+private:
+  FILE *m_file = nullptr;
+  // bytes left after the current position
+  uint64_t m_remaining = 0;
+  bool m_failed = false;
+};
+
+constexpr char FrameMagic[4] = {'P','F','R','M'};
+constexpr uint32_t FrameVersion = 1;
+
+#endif
@@ -0,0 +1,185 @@
+// generic version of the ParticlePool, objects live in fixed size chunks so
+// growing the pool never moves a live object and callers refer to them through
+// generation checked handles so a stale handle can't see a recycled object
+#ifndef OBJECTPOOL_H_
+#define OBJECTPOOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+// 24 bits of slot index and 8 of generation. The generation wraps after a
+// slot has been reused 256 times, a handle kept that long validates again
+// and sees whatever object is in the slot now, so don't hold on to handles to
+// objects that churn that quickly.
+class PoolHandle
+{
+public:
+  static constexpr uint32_t IndexBits = 24;
+  static constexpr uint32_t IndexMask = (1u<<IndexBits)-1;
+  // the top index is reserved to mean invalid
+  static constexpr uint32_t MaxIndex = IndexMask-1;
+
+  PoolHandle() : m_value(IndexMask) {}
+  PoolHandle(uint32_t _index, uint32_t _generation) :
+    m_value((_generation<<IndexBits) | (_index & IndexMask)) {}
+  bool isValid() const { return index() != IndexMask; }
+  uint32_t index() const { return m_value & IndexMask; }
+  uint32_t generation() const { return m_value >> IndexBits; }
+  uint32_t value() const { return m_value; }
+  bool operator==(const PoolHandle &_h) const { return m_value == _h.m_value; }
+  bool operator!=(const PoolHandle &_h) const { return m_value != _h.m_value; }
+private:
+  uint32_t m_value;
+};
+
+/// FixedCapacity > 0 allocates everything up front and never grows, otherwise
+/// the pool adds ChunkSize slots at a time up to the maximum given at runtime.
+template <typename T, size_t FixedCapacity=0,
+          size_t ChunkSize=(FixedCapacity>0 ? FixedCapacity : 1024)>
+class ObjectPool
+{
+  static_assert(FixedCapacity <= PoolHandle::MaxIndex+1, "FixedCapacity too big for a PoolHandle");
+  static_assert(ChunkSize > 0, "ChunkSize must be positive");
+public:
+  static constexpr size_t MaxCapacity = FixedCapacity>0 ? FixedCapacity : PoolHandle::MaxIndex+1;
+
+  ObjectPool() : ObjectPool(FixedCapacity, MaxCapacity) {}
+  explicit ObjectPool(size_t _initialCapacity, size_t _maxCapacity=MaxCapacity) :
+    m_maxCapacity(_maxCapacity < MaxCapacity ? _maxCapacity : MaxCapacity)
+  {
+    bool room = true;
+    while (capacity() < _initialCapacity && room)
+    {
+      room = grow();
+    }
+  }
+  ~ObjectPool()
+  {
+    for (size_t i=0; i<capacity(); ++i)
+    {
+      Slot &s = slot(i);
+      if (s.inUse)
+      {
+        s.object()->~T();
+      }
+    }
+  }
+  ObjectPool(const ObjectPool &)=delete;
+  ObjectPool &operator=(const ObjectPool &)=delete;
+
+  /// returns an invalid handle if the pool is at its maximum capacity
+  template <typename... Args>
+  PoolHandle create(Args &&... _args)
+  {
+    if (m_firstAvailable == PoolHandle::IndexMask && !grow())
+    {
+      return PoolHandle();
+    }
+    uint32_t index = m_firstAvailable;
+    Slot &s = slot(index);
+    m_firstAvailable = s.next;
+    // the constructor overwrites the free list link
+    new (s.storage) T(std::forward<Args>(_args)...);
+    s.inUse = true;
+    ++m_size;
+    return PoolHandle(index, s.generation);
+  }
+
+  /// destroys the object and invalidates every handle to it
+  void release(PoolHandle _h)
+  {
+    if (get(_h) == nullptr)
+    {
+      return;
+    }
+    Slot &s = slot(_h.index());
+    s.object()->~T();
+    s.inUse = false;
+    ++s.generation;
+    s.next = m_firstAvailable;
+    m_firstAvailable = _h.index();
+    --m_size;
+  }
+
+  /// returns nullptr if the handle is stale or invalid, only the low 8 bits of
+  /// the generation are compared (see PoolHandle)
+  T *get(PoolHandle _h)
+  {
+    if (_h.index() >= capacity())
+    {
+      return nullptr;
+    }
+    Slot &s = slot(_h.index());
+    return (s.inUse && (s.generation & GenerationMask) == _h.generation()) ? s.object() : nullptr;
+  }
+  const T *get(PoolHandle _h) const { return const_cast<ObjectPool *>(this)->get(_h); }
+
+  template <typename F>
+  void forEach(F &&_f)
+  {
+    for (size_t i=0; i<capacity(); ++i)
+    {
+      Slot &s = slot(i);
+      if (s.inUse)
+      {
+        _f(*s.object());
+      }
+    }
+  }
+
+  size_t size() const { return m_size; }
+  size_t capacity() const
+  {
+    size_t allocated = m_chunks.size()*ChunkSize;
+    return allocated < m_maxCapacity ? allocated : m_maxCapacity;
+  }
+  size_t maxCapacity() const { return m_maxCapacity; }
+
+private:
+  static constexpr uint32_t GenerationMask = 0xffffffffu >> PoolHandle::IndexBits;
+
+  struct Slot
+  {
+    // as with Particle a free slot keeps the next free index in the object storage
+    union
+    {
+      alignas(T) unsigned char storage[sizeof(T)];
+      uint32_t next;
+    };
+    uint32_t generation = 0;
+    bool inUse = false;
+    T *object() { return reinterpret_cast<T *>(storage); }
+  };
+
+  Slot &slot(size_t _i) { return m_chunks[_i/ChunkSize][_i%ChunkSize]; }
+
+  // adds a chunk and links it onto the free list, false if we are at the limit
+  bool grow()
+  {
+    size_t first = capacity();
+    if (first >= m_maxCapacity)
+    {
+      return false;
+    }
+    m_chunks.emplace_back(new Slot[ChunkSize]);
+    // a partial last chunk is allocated but never handed out
+    size_t last = first+ChunkSize < m_maxCapacity ? first+ChunkSize : m_maxCapacity;
+    for (size_t i=last; i>first; --i)
+    {
+      slot(i-1).next = m_firstAvailable;
+      m_firstAvailable = static_cast<uint32_t>(i-1);
+    }
+    return true;
+  }
+
+  std::vector<std::unique_ptr<Slot[]>> m_chunks;
+  uint32_t m_firstAvailable = PoolHandle::IndexMask;
+  size_t m_size = 0;
+  size_t m_maxCapacity;
+};
+
+#endif
@@ -1,26 +1,33 @@
 #include "Particle.h"
-#include <iostream>
-int Particle::m_id=0;
+#include "Fixed16.h"
+template <typename T>
+std::atomic<int> Particle<T>::m_id{0};
 
-void Particle::init(double _x, double _y,double _xVel, double _yVel, int _lifetime)
+template <typename T>
+void Particle<T>::init(T _x, T _y,T _xVel, T _yVel, int _lifetime)
 {
-  m_x = _x;
-  m_y = _y;
-  m_xVel = _xVel;
-  m_yVel = _yVel;
+  m_state.live.x = _x;
+  m_state.live.y = _y;
+  m_state.live.xVel = _xVel;
+  m_state.live.yVel = _yVel;
   m_framesLeft = _lifetime;
-  m_id++;
+  m_id.fetch_add(1, std::memory_order_relaxed);
 }
 
 
-void Particle::animate()
+template <typename T>
+bool Particle<T>::animate()
 {
   if (!inUse())
   {
-    return;
+    return false;
   }
   m_framesLeft--;
-  m_x += m_xVel;
-  m_y += m_yVel;
-  std::cout<<"Particle "<<m_x<<" "<<m_y<<std::endl;
+  m_state.live.x += m_state.live.xVel;
+  m_state.live.y += m_state.live.yVel;
+  return m_framesLeft == 0;
 }
+
+template class Particle<float>;
+template class Particle<double>;
+template class Particle<Fixed16>;
@@ -2,20 +2,44 @@
 #ifndef PARTICLE_H_
 #define PARTICLE_H_
 
+#include <atomic>
+
+// T is the scalar used for position and velocity, Particle.cpp instantiates
+// float, double and Fixed16
+template <typename T>
 class Particle
 {
 public:
   Particle()  : m_framesLeft(0){}
 
-  void init(double _x, double _y,double _xVel, double _yVel, int _lifetime);
-  void animate();
+  void init(T _x, T _y,T _xVel, T _yVel, int _lifetime);
+  // returns true if the particle died this frame so the pool can reclaim it
+  bool animate();
   bool inUse() const { return m_framesLeft > 0; }
-  int id()const {return m_id;}
+  void kill() { m_framesLeft=0; }
+  // how many particles of this type have been initialised so far
+  int id()const {return m_id.load(std::memory_order_relaxed);}
+  // only valid while the particle is in use
+  T x() const { return m_state.live.x; }
+  T y() const { return m_state.live.y; }
+  // only valid when the particle is not in use
+  Particle *getNext() const { return m_state.next; }
+  void setNext(Particle *_next) { m_state.next = _next; }
 private:
   int m_framesLeft;
-  double m_x, m_y;
-  double m_xVel, m_yVel;
-  static int m_id;
+  // a live particle needs its position and velocity, a dead one only needs
+  // to know the next free particle so they share the same storage
+  union
+  {
+    struct
+    {
+      T x, y;
+      T xVel, yVel;
+    } live;
+    Particle *next;
+  } m_state;
+  // atomic so pools on different threads can init particles at the same time
+  static std::atomic<int> m_id;
 
 };
 
@@ -1,23 +1,221 @@
 #include "ParticlePool.h"
-#include <iostream>
-void ParticlePool::animate()
+#include "Fixed16.h"
+
+template <typename T>
+ParticlePool<T>::ParticlePool(size_t _capacity) : m_particles(_capacity)
+{
+  // every particle starts off free so chain them all together
+  m_firstAvailable = nullptr;
+  for (size_t i=_capacity; i>0; --i)
+  {
+    m_particles[i-1].setNext(m_firstAvailable);
+    m_firstAvailable = &m_particles[i-1];
+  }
+}
+
+template <typename T>
+void ParticlePool<T>::animate()
 {
   for (auto &p : m_particles)
   {
-    p.animate();
+    if (p.animate())
+    {
+      // it died this frame so put it at the front of the free list
+      p.setNext(m_firstAvailable);
+      m_firstAvailable = &p;
+      --m_live;
+    }
   }
 }
 
-void ParticlePool::create(double _x, double _y,double _xVel, double _yVel, int _lifetime)
+// smallest number of particles that covers a whole number of cache lines
+template <typename T>
+static size_t cacheLineMultiple()
 {
-  // Find an available particle.
+  size_t a = sizeof(T);
+  size_t b = CacheLineSize;
+  while (b != 0)
+  {
+    size_t t = a%b;
+    a = b;
+    b = t;
+  }
+  return CacheLineSize/a;
+}
+
+template <typename T>
+void ParticlePool<T>::animate(WorkerPool &_workers, size_t _grain)
+{
+  size_t unit = cacheLineMultiple<ParticleType>();
+  size_t blockSize = (_grain+unit-1)/unit*unit;
+  if (blockSize == 0)
+  {
+    blockSize = unit;
+  }
+  size_t blocks = (m_particles.size()+blockSize-1)/blockSize;
+  m_blockDeaths.assign(blocks, BlockDeaths());
+  _workers.parallelFor(m_particles.size(), blockSize, [this, blockSize](size_t _begin, size_t _end)
+  {
+    // chain the dead particles of this block together in the same order the
+    // serial loop would have pushed them, the links live in each particle so
+    // no two blocks touch the same memory
+    auto &deaths = m_blockDeaths[_begin/blockSize];
+    for (size_t i=_begin; i<_end; ++i)
+    {
+      ParticleType &p = m_particles[i];
+      if (p.animate())
+      {
+        p.setNext(deaths.head);
+        if (deaths.head == nullptr)
+        {
+          deaths.tail = &p;
+        }
+        deaths.head = &p;
+        ++deaths.count;
+      }
+    }
+  });
+  // splice the blocks onto the free list in order so it matches animate()
+  for (auto &deaths : m_blockDeaths)
+  {
+    if (deaths.head != nullptr)
+    {
+      deaths.tail->setNext(m_firstAvailable);
+      m_firstAvailable = deaths.head;
+      m_live -= deaths.count;
+    }
+  }
+}
+
+template <typename T>
+typename ParticlePool<T>::ParticleType *ParticlePool<T>::create(T _x, T _y,T _xVel, T _yVel, int _lifetime)
+{
+  // pool is full, a dead on arrival particle would also be lost from the free list
+  if (m_firstAvailable == nullptr || _lifetime <= 0)
+  {
+    return nullptr;
+  }
+  // remove it from the free list before init overwrites the link
+  ParticleType *p = m_firstAvailable;
+  m_firstAvailable = p->getNext();
+  p->init(_x, _y, _xVel, _yVel, _lifetime);
+  ++m_live;
+  return p;
+}
+
+template <typename T>
+size_t ParticlePool<T>::claim(size_t _count)
+{
+  m_claimed.clear();
+  while (m_claimed.size() < _count && m_firstAvailable != nullptr)
+  {
+    m_claimed.push_back(m_firstAvailable);
+    m_firstAvailable = m_firstAvailable->getNext();
+  }
+  m_live += m_claimed.size();
+  return m_claimed.size();
+}
+
+template <typename T>
+size_t ParticlePool<T>::create(size_t _count, T _x, T _y,T _xVel, T _yVel, int _lifetime)
+{
+  if (_lifetime <= 0)
+  {
+    return 0;
+  }
+  // every particle gets the same values so unlink and init in the same pass
+  size_t n=0;
+  while (n < _count && m_firstAvailable != nullptr)
+  {
+    ParticleType *p = m_firstAvailable;
+    m_firstAvailable = p->getNext();
+    p->init(_x, _y, _xVel, _yVel, _lifetime);
+    ++n;
+  }
+  m_live += n;
+  return n;
+}
+
+template <typename T>
+size_t ParticlePool<T>::emit(Emitter &_emitter, size_t _count)
+{
+  size_t n = claim(_count);
+  _emitter.generate(n, m_batch);
+  for (size_t i=0; i<n; ++i)
+  {
+    // a non positive lifetime would leave the particle off the free list
+    int lifetime = m_batch.lifetime[i] > 0 ? m_batch.lifetime[i] : 1;
+    m_claimed[i]->init(static_cast<T>(m_batch.x[i]), static_cast<T>(m_batch.y[i]),
+                       static_cast<T>(m_batch.xVel[i]), static_cast<T>(m_batch.yVel[i]), lifetime);
+  }
+  return n;
+}
+
+template <typename T>
+void ParticlePool<T>::spawn(T _x, T _y,T _xVel, T _yVel, int _lifetime)
+{
+  m_spawnQueue.push(static_cast<double>(_x), static_cast<double>(_y),
+                    static_cast<double>(_xVel), static_cast<double>(_yVel), _lifetime);
+}
+
+template <typename T>
+size_t ParticlePool<T>::commitSpawns()
+{
+  size_t created=0;
+  m_spawnQueue.drain([this, &created](const SpawnBatch &_batch)
+  {
+    // anything that doesn't fit is dropped, the same as create
+    size_t n = claim(_batch.size());
+    for (size_t i=0; i<n; ++i)
+    {
+      int lifetime = _batch.lifetime[i] > 0 ? _batch.lifetime[i] : 1;
+      m_claimed[i]->init(static_cast<T>(_batch.x[i]), static_cast<T>(_batch.y[i]),
+                         static_cast<T>(_batch.xVel[i]), static_cast<T>(_batch.yVel[i]), lifetime);
+    }
+    created += n;
+  });
+  return created;
+}
+
+template <typename T>
+void ParticlePool<T>::release(ParticleType *_p)
+{
+  if (!_p->inUse())
+  {
+    return;
+  }
+  _p->kill();
+  _p->setNext(m_firstAvailable);
+  m_firstAvailable = _p;
+  --m_live;
+}
+
+template <typename T>
+bool ParticlePool<T>::writeFrame(FrameWriter &_writer, uint32_t _frame)
+{
+  m_frameData.clear();
   for (auto &p : m_particles)
   {
-    if (!p.inUse())
+    if (p.inUse())
     {
-      std::cout<<p.id()<<'\n';
-      p.init(_x, _y, _xVel, _yVel, _lifetime);
-      return;
+      m_frameData.push_back(static_cast<double>(p.x()));
+      m_frameData.push_back(static_cast<double>(p.y()));
     }
   }
+  return _writer.writeFrame(_frame, m_frameData.data(), static_cast<uint32_t>(m_frameData.size()/2));
 }
+
+template <typename T>
+size_t ParticlePool<T>::memoryBytes() const
+{
+  return sizeof(*this)+
+         m_particles.capacity()*sizeof(ParticleType)+
+         m_blockDeaths.capacity()*sizeof(BlockDeaths)+
+         m_frameData.capacity()*sizeof(double)+
+         m_claimed.capacity()*sizeof(ParticleType *)+
+         m_batch.lifetime.capacity()*(4*sizeof(double)+sizeof(int));
+}
+
+template class ParticlePool<float>;
+template class ParticlePool<double>;
+template class ParticlePool<Fixed16>;
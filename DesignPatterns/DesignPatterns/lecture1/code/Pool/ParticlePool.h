@@ -2,19 +2,79 @@
 #ifndef PARTICLEPOOL_H_
 #define PARTICLEPOOL_H_
 
-#include <array>
+#include <cstddef>
+#include <vector>
+#include "AlignedAllocator.h"
+#include "Emitter.h"
+#include "FrameStream.h"
 #include "Particle.h"
+#include "SpawnQueue.h"
+#include "WorkerPool.h"
+// ParticlePool.cpp instantiates the pool for float, double and Fixed16
+template <typename T>
 class ParticlePool
 {
 public:
-  void create(double _x, double _y,double _xVel, double _yVel, int _lifetime);
+  using ParticleType = Particle<T>;
+  static constexpr size_t DefaultPoolSize = 100;
+  explicit ParticlePool(size_t _capacity=DefaultPoolSize);
+  // the free list points into m_particles so a copy would share it
+  ParticlePool(const ParticlePool &)=delete;
+  ParticlePool &operator=(const ParticlePool &)=delete;
+  // returns nullptr if the pool is full or _lifetime is not positive
+  ParticleType *create(T _x, T _y,T _xVel, T _yVel, int _lifetime);
+  // create up to _count identical particles in one pass, returns how many fitted
+  size_t create(size_t _count, T _x, T _y,T _xVel, T _yVel, int _lifetime);
+  // spawn a burst of up to _count particles from _emitter, returns how many fitted
+  size_t emit(Emitter &_emitter, size_t _count);
+  // spawn this frame's worth of particles from _emitter
+  size_t emit(Emitter &_emitter) { return emit(_emitter, _emitter.rate()); }
+  // queue a particle from any thread, it is created by the next commitSpawns
+  void spawn(T _x, T _y,T _xVel, T _yVel, int _lifetime);
+  // create everything queued by spawn, call from the thread that owns the pool
+  // before animating, returns how many fitted
+  size_t commitSpawns();
+  // return a particle to the pool before its lifetime is up
+  void release(ParticleType *_p);
 
   void animate();
+  // splits the pool into blocks of at least _grain particles that start on a
+  // cache line and updates them on _workers. The result is bit identical to
+  // animate() whatever the thread count.
+  void animate(WorkerPool &_workers, size_t _grain=4096);
+  // write the positions of all live particles as one record, false if the
+  // writer has failed
+  bool writeFrame(FrameWriter &_writer, uint32_t _frame);
+  size_t capacity() const { return m_particles.size(); }
+  const ParticleType &particle(size_t _i) const { return m_particles[_i]; }
+  size_t liveCount() const { return m_live; }
+  // bytes owned by the pool including its scratch buffers
+  size_t memoryBytes() const;
 
 
 private:
-  static constexpr int PoolSize = 100;
-  std::array<Particle,PoolSize> m_particles;
+  // unlink up to _count particles from the free list into m_claimed
+  size_t claim(size_t _count);
+  // sized once in the ctor and never resized so the free list pointers stay valid
+  std::vector<ParticleType,AlignedAllocator<ParticleType>> m_particles;
+  // head of the free list threaded through the dead particles
+  ParticleType *m_firstAvailable;
+  size_t m_live=0;
+  // the particles that died in one block during a parallel animate, head is
+  // the last to die so the chain matches the serial free list order
+  struct BlockDeaths
+  {
+    ParticleType *head=nullptr;
+    ParticleType *tail=nullptr;
+    size_t count=0;
+  };
+  std::vector<BlockDeaths> m_blockDeaths;
+  // reused by writeFrame so exporting doesn't allocate every frame
+  std::vector<double> m_frameData;
+  // scratch space for the batched create / emit
+  std::vector<ParticleType *> m_claimed;
+  SpawnBatch m_batch;
+  SpawnQueue m_spawnQueue;
 };
 
 
@@ -0,0 +1,310 @@
+#include "ParticlePoolSoA.h"
+#include "Fixed16.h"
+#if defined(__AVX2__)
+  #include <immintrin.h>
+#elif defined(__SSE2__)
+  #include <emmintrin.h>
+#endif
+
+template <typename T>
+ParticlePoolSoA<T>::ParticlePoolSoA(size_t _capacity, Mode _mode) :
+  m_mode(_mode),
+  m_x(_capacity), m_y(_capacity),
+  m_xVel(_capacity), m_yVel(_capacity),
+  m_framesLeft(_capacity,0)
+{
+  if (m_mode == Mode::Compact)
+  {
+    return;
+  }
+  // push in reverse so the first particles created are at the front
+  m_free.reserve(_capacity);
+  for (size_t i=_capacity; i>0; --i)
+  {
+    m_free.push_back(static_cast<int>(i-1));
+  }
+}
+
+template <typename T>
+int ParticlePoolSoA<T>::create(T _x, T _y,T _xVel, T _yVel, int _lifetime)
+{
+  const int *slot;
+  if (_lifetime <= 0 || claim(1, slot) == 0)
+  {
+    return -1;
+  }
+  int i = m_mode == Mode::Compact ? static_cast<int>(m_live-1) : *slot;
+  popClaimed(1);
+  m_x[i] = _x;
+  m_y[i] = _y;
+  m_xVel[i] = _xVel;
+  m_yVel[i] = _yVel;
+  m_framesLeft[i] = _lifetime;
+  return i;
+}
+
+template <typename T>
+size_t ParticlePoolSoA<T>::claim(size_t _count, const int *&_slots)
+{
+  if (m_mode == Mode::Compact)
+  {
+    size_t n = _count < capacity()-m_live ? _count : capacity()-m_live;
+    m_live += n;
+    _slots = nullptr;
+    return n;
+  }
+  // the burst is simply the top _count entries of the free stack
+  size_t n = _count < m_free.size() ? _count : m_free.size();
+  _slots = m_free.data()+m_free.size()-n;
+  return n;
+}
+
+template <typename T>
+void ParticlePoolSoA<T>::popClaimed(size_t _count)
+{
+  if (m_mode != Mode::Compact)
+  {
+    m_free.resize(m_free.size()-_count);
+  }
+}
+
+template <typename T>
+size_t ParticlePoolSoA<T>::emit(Emitter &_emitter, size_t _count)
+{
+  const int *slots;
+  size_t n = claim(_count, slots);
+  _emitter.generate(n, m_batch);
+  if (m_mode == Mode::Compact)
+  {
+    // one contiguous run on the end of the live range
+    size_t first = m_live-n;
+    for (size_t i=0; i<n; ++i)
+    {
+      m_x[first+i] = static_cast<T>(m_batch.x[i]);
+      m_y[first+i] = static_cast<T>(m_batch.y[i]);
+      m_xVel[first+i] = static_cast<T>(m_batch.xVel[i]);
+      m_yVel[first+i] = static_cast<T>(m_batch.yVel[i]);
+      m_framesLeft[first+i] = m_batch.lifetime[i] > 0 ? m_batch.lifetime[i] : 1;
+    }
+    return n;
+  }
+  for (size_t i=0; i<n; ++i)
+  {
+    int s = slots[i];
+    m_x[s] = static_cast<T>(m_batch.x[i]);
+    m_y[s] = static_cast<T>(m_batch.y[i]);
+    m_xVel[s] = static_cast<T>(m_batch.xVel[i]);
+    m_yVel[s] = static_cast<T>(m_batch.yVel[i]);
+    m_framesLeft[s] = m_batch.lifetime[i] > 0 ? m_batch.lifetime[i] : 1;
+  }
+  popClaimed(n);
+  return n;
+}
+
+template <typename T>
+void ParticlePoolSoA<T>::animate()
+{
+  if (m_mode == Mode::Compact)
+  {
+    animateLive();
+    removeDead();
+  }
+  else
+  {
+    animateBlock(0, capacity());
+  }
+}
+
+template <typename T>
+void ParticlePoolSoA<T>::animateLive()
+{
+  // plain loop over raw pointers, no branches so the compiler vectorizes it
+  T *x = m_x.data();
+  T *y = m_y.data();
+  const T *xVel = m_xVel.data();
+  const T *yVel = m_yVel.data();
+  int *framesLeft = m_framesLeft.data();
+  for (size_t i=0; i<m_live; ++i)
+  {
+    x[i] += xVel[i];
+    y[i] += yVel[i];
+    --framesLeft[i];
+  }
+}
+
+// Walk down from the top of the live range moving the last live particle into
+// each gap. Going downwards means everything above i is already known to be
+// alive so the particle moved in never needs checking again.
+template <typename T>
+void ParticlePoolSoA<T>::removeDead()
+{
+  for (size_t i=m_live; i>0; --i)
+  {
+    size_t dead = i-1;
+    if (m_framesLeft[dead] > 0)
+    {
+      continue;
+    }
+    size_t last = --m_live;
+    m_x[dead] = m_x[last];
+    m_y[dead] = m_y[last];
+    m_xVel[dead] = m_xVel[last];
+    m_yVel[dead] = m_yVel[last];
+    m_framesLeft[dead] = m_framesLeft[last];
+    m_framesLeft[last] = 0;
+  }
+}
+
+template <typename T>
+void ParticlePoolSoA<T>::animateScalar(size_t _begin, size_t _end)
+{
+  for (size_t i=_begin; i<_end; ++i)
+  {
+    if (m_framesLeft[i] > 0)
+    {
+      m_x[i] += m_xVel[i];
+      m_y[i] += m_yVel[i];
+      if (--m_framesLeft[i] == 0)
+      {
+        m_free.push_back(static_cast<int>(i));
+      }
+    }
+  }
+}
+
+template <typename T>
+size_t ParticlePoolSoA<T>::memoryBytes() const
+{
+  return sizeof(*this)+
+         (m_x.capacity()+m_y.capacity()+m_xVel.capacity()+m_yVel.capacity())*sizeof(T)+
+         (m_framesLeft.capacity()+m_free.capacity())*sizeof(int)+
+         m_batch.lifetime.capacity()*(4*sizeof(double)+sizeof(int));
+}
+
+template <typename T>
+void ParticlePoolSoA<T>::freeLanes(int _died, size_t _first, int _lanes)
+{
+  if (_died == 0)
+  {
+    return;
+  }
+  for (int lane=0; lane<_lanes; ++lane)
+  {
+    if (_died & (1<<lane))
+    {
+      m_free.push_back(static_cast<int>(_first+lane));
+    }
+  }
+}
+
+// no SIMD version for this type
+template <typename T>
+void ParticlePoolSoA<T>::animateBlock(size_t _begin, size_t _end)
+{
+  animateScalar(_begin, _end);
+}
+
+// Each step handles 4 particles, the lifetimes are compared against 0 to give
+// an alive mask which is widened to 64 bits and used to select the new
+// positions so dead particles are left exactly as they were.
+template <>
+void ParticlePoolSoA<double>::animateBlock(size_t _begin, size_t _end)
+{
+  size_t i=_begin;
+#if defined(__AVX2__) || defined(__SSE2__)
+  double *x = m_x.data();
+  double *y = m_y.data();
+  const double *xVel = m_xVel.data();
+  const double *yVel = m_yVel.data();
+  int *framesLeft = m_framesLeft.data();
+  const __m128i zero = _mm_setzero_si128();
+  for (; i+4<=_end; i+=4)
+  {
+    __m128i life = _mm_loadu_si128(reinterpret_cast<const __m128i *>(framesLeft+i));
+    __m128i alive = _mm_cmpgt_epi32(life, zero);
+    // alive lanes are -1 so adding the mask decrements just those
+    life = _mm_add_epi32(life, alive);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(framesLeft+i), life);
+  #if defined(__AVX2__)
+    __m256d mask = _mm256_castsi256_pd(_mm256_cvtepi32_epi64(alive));
+    __m256d px = _mm256_loadu_pd(x+i);
+    __m256d py = _mm256_loadu_pd(y+i);
+    px = _mm256_blendv_pd(px, _mm256_add_pd(px, _mm256_loadu_pd(xVel+i)), mask);
+    py = _mm256_blendv_pd(py, _mm256_add_pd(py, _mm256_loadu_pd(yVel+i)), mask);
+    _mm256_storeu_pd(x+i, px);
+    _mm256_storeu_pd(y+i, py);
+  #else
+    // SSE2 has no blend so select with and / andnot / or, two lanes at a time
+    for (int half=0; half<2; ++half)
+    {
+      __m128d mask = _mm_castsi128_pd(half==0 ? _mm_unpacklo_epi32(alive, alive)
+                                              : _mm_unpackhi_epi32(alive, alive));
+      size_t j = i+2*half;
+      __m128d px = _mm_loadu_pd(x+j);
+      __m128d py = _mm_loadu_pd(y+j);
+      __m128d nx = _mm_add_pd(px, _mm_loadu_pd(xVel+j));
+      __m128d ny = _mm_add_pd(py, _mm_loadu_pd(yVel+j));
+      _mm_storeu_pd(x+j, _mm_or_pd(_mm_and_pd(mask, nx), _mm_andnot_pd(mask, px)));
+      _mm_storeu_pd(y+j, _mm_or_pd(_mm_and_pd(mask, ny), _mm_andnot_pd(mask, py)));
+    }
+  #endif
+    // anything alive that has now reached zero goes back on the free stack
+    freeLanes(_mm_movemask_ps(_mm_castsi128_ps(_mm_and_si128(alive, _mm_cmpeq_epi32(life, zero)))), i, 4);
+  }
+#endif
+  // whatever is left over (or everything if there is no SIMD)
+  animateScalar(i, _end);
+}
+
+// float lanes are the same width as the lifetimes so the alive mask can be
+// used directly, 8 particles a step with AVX2 and 4 with SSE2
+template <>
+void ParticlePoolSoA<float>::animateBlock(size_t _begin, size_t _end)
+{
+  size_t i=_begin;
+#if defined(__AVX2__) || defined(__SSE2__)
+  float *x = m_x.data();
+  float *y = m_y.data();
+  const float *xVel = m_xVel.data();
+  const float *yVel = m_yVel.data();
+  int *framesLeft = m_framesLeft.data();
+  #if defined(__AVX2__)
+  const __m256i zero = _mm256_setzero_si256();
+  for (; i+8<=_end; i+=8)
+  {
+    __m256i life = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(framesLeft+i));
+    __m256i alive = _mm256_cmpgt_epi32(life, zero);
+    life = _mm256_add_epi32(life, alive);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(framesLeft+i), life);
+    __m256 mask = _mm256_castsi256_ps(alive);
+    __m256 px = _mm256_loadu_ps(x+i);
+    __m256 py = _mm256_loadu_ps(y+i);
+    _mm256_storeu_ps(x+i, _mm256_blendv_ps(px, _mm256_add_ps(px, _mm256_loadu_ps(xVel+i)), mask));
+    _mm256_storeu_ps(y+i, _mm256_blendv_ps(py, _mm256_add_ps(py, _mm256_loadu_ps(yVel+i)), mask));
+    freeLanes(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_and_si256(alive, _mm256_cmpeq_epi32(life, zero)))), i, 8);
+  }
+  #else
+  const __m128i zero = _mm_setzero_si128();
+  for (; i+4<=_end; i+=4)
+  {
+    __m128i life = _mm_loadu_si128(reinterpret_cast<const __m128i *>(framesLeft+i));
+    __m128i alive = _mm_cmpgt_epi32(life, zero);
+    life = _mm_add_epi32(life, alive);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(framesLeft+i), life);
+    __m128 mask = _mm_castsi128_ps(alive);
+    __m128 px = _mm_loadu_ps(x+i);
+    __m128 py = _mm_loadu_ps(y+i);
+    __m128 nx = _mm_add_ps(px, _mm_loadu_ps(xVel+i));
+    __m128 ny = _mm_add_ps(py, _mm_loadu_ps(yVel+i));
+    _mm_storeu_ps(x+i, _mm_or_ps(_mm_and_ps(mask, nx), _mm_andnot_ps(mask, px)));
+    _mm_storeu_ps(y+i, _mm_or_ps(_mm_and_ps(mask, ny), _mm_andnot_ps(mask, py)));
+    freeLanes(_mm_movemask_ps(_mm_castsi128_ps(_mm_and_si128(alive, _mm_cmpeq_epi32(life, zero)))), i, 4);
+  }
+  #endif
+#endif
+  animateScalar(i, _end);
+}
+
+template class ParticlePoolSoA<float>;
+template class ParticlePoolSoA<double>;
+template class ParticlePoolSoA<Fixed16>;
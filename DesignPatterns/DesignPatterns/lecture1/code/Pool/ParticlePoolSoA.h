@@ -0,0 +1,61 @@
+// structure of arrays version of the ParticlePool, each attribute lives in its
+// own contiguous array so a whole block of particles can be updated with SIMD
+#ifndef PARTICLEPOOLSOA_H_
+#define PARTICLEPOOLSOA_H_
+
+#include <cstddef>
+#include <vector>
+#include "Emitter.h"
+
+// T is the scalar for position and velocity, float and double have hand
+// written SIMD kernels and anything else (Fixed16) uses the scalar loop
+template <typename T>
+class ParticlePoolSoA
+{
+public:
+  // FreeList keeps a particle at the same index for its whole life.
+  // Compact keeps the live particles packed in [0,liveCount()) by moving the
+  // last one into the gap when a particle dies, so animate only touches live
+  // particles but indices are only valid until the next animate.
+  enum class Mode { FreeList, Compact };
+  explicit ParticlePoolSoA(size_t _capacity, Mode _mode=Mode::FreeList);
+  // returns the index of the new particle or -1 if the pool is full
+  int create(T _x, T _y,T _xVel, T _yVel, int _lifetime);
+  // spawn a burst of up to _count particles from _emitter, returns how many fitted
+  size_t emit(Emitter &_emitter, size_t _count);
+  void animate();
+
+  size_t capacity() const { return m_framesLeft.size(); }
+  size_t liveCount() const { return m_mode == Mode::Compact ? m_live : capacity()-m_free.size(); }
+  Mode mode() const { return m_mode; }
+  // bytes owned by the pool including its scratch buffers
+  size_t memoryBytes() const;
+  bool inUse(size_t _i) const { return m_framesLeft[_i] > 0; }
+  T x(size_t _i) const { return m_x[_i]; }
+  T y(size_t _i) const { return m_y[_i]; }
+
+private:
+  // integrate [_begin,_end) using AVX2, SSE2 or plain C++ depending on the build
+  void animateBlock(size_t _begin, size_t _end);
+  void animateScalar(size_t _begin, size_t _end);
+  // push the lanes set in _died back on the free stack
+  void freeLanes(int _died, size_t _first, int _lanes);
+  // Compact mode, everything below m_live is alive so there is no mask at all
+  void animateLive();
+  void removeDead();
+  // where the next _count particles go, the top of the free stack or the end
+  // of the live range. Free stack slots stay on the stack until popClaimed so
+  // _slots is only good until then.
+  size_t claim(size_t _count, const int *&_slots);
+  void popClaimed(size_t _count);
+  Mode m_mode;
+  size_t m_live=0;
+  std::vector<T> m_x, m_y;
+  std::vector<T> m_xVel, m_yVel;
+  std::vector<int> m_framesLeft;
+  // stack of free indices so create is still O(1), unused in Compact mode
+  std::vector<int> m_free;
+  SpawnBatch m_batch;
+};
+
+#endif
@@ -0,0 +1,32 @@
+#include "SpawnQueue.h"
+#include <atomic>
+#include <unordered_map>
+
+SpawnQueue::SpawnQueue()
+{
+  static std::atomic<uint64_t> s_nextSerial{0};
+  m_serial = s_nextSerial++;
+}
+
+SpawnQueue::Buffer &SpawnQueue::localBuffer()
+{
+  // each thread remembers its buffer for every queue it has pushed to
+  thread_local std::unordered_map<uint64_t, Buffer *> t_buffers;
+  auto it = t_buffers.find(m_serial);
+  if (it != t_buffers.end())
+  {
+    return *it->second;
+  }
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_buffers.emplace_back(new Buffer);
+  Buffer *b = m_buffers.back().get();
+  t_buffers[m_serial] = b;
+  return *b;
+}
+
+void SpawnQueue::push(double _x, double _y, double _xVel, double _yVel, int _lifetime)
+{
+  Buffer &b = localBuffer();
+  std::lock_guard<std::mutex> lock(b.mutex);
+  b.batch.add(_x, _y, _xVel, _yVel, _lifetime);
+}
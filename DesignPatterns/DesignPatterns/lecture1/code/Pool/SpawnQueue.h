@@ -0,0 +1,51 @@
+// lets any thread request particles without touching the pool, each thread
+// gets its own buffer and the owner of the pool drains them all at frame start
+#ifndef SPAWNQUEUE_H_
+#define SPAWNQUEUE_H_
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "Emitter.h"
+
+class SpawnQueue
+{
+public:
+  SpawnQueue();
+  SpawnQueue(const SpawnQueue &)=delete;
+  SpawnQueue &operator=(const SpawnQueue &)=delete;
+  // safe to call from any thread
+  void push(double _x, double _y, double _xVel, double _yVel, int _lifetime);
+  // calls _f(batch) for each thread's buffer then empties it, buffers are
+  // visited in the order the threads first pushed
+  template <typename F>
+  void drain(F &&_f)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto &b : m_buffers)
+    {
+      std::lock_guard<std::mutex> bufferLock(b->mutex);
+      if (b->batch.size() > 0)
+      {
+        _f(static_cast<const SpawnBatch &>(b->batch));
+        b->batch.clear();
+      }
+    }
+  }
+private:
+  struct Buffer
+  {
+    // only contended while the queue is being drained
+    std::mutex mutex;
+    SpawnBatch batch;
+  };
+  Buffer &localBuffer();
+  // unique for the life of the process so a thread's cached buffer can't be
+  // mistaken for one belonging to a new queue at the same address
+  uint64_t m_serial;
+  std::mutex m_mutex;
+  std::vector<std::unique_ptr<Buffer>> m_buffers;
+};
+
+#endif
@@ -0,0 +1,82 @@
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool(size_t _threads)
+{
+  for (size_t i=1; i<_threads; ++i)
+  {
+    m_threads.emplace_back(&WorkerPool::worker, this);
+  }
+}
+
+WorkerPool::~WorkerPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_quit = true;
+  }
+  m_wake.notify_all();
+  for (auto &t : m_threads)
+  {
+    t.join();
+  }
+}
+
+void WorkerPool::parallelFor(size_t _count, size_t _blockSize, const std::function<void(size_t,size_t)> &_f)
+{
+  if (_count == 0)
+  {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_job = &_f;
+    m_count = _count;
+    m_blockSize = _blockSize > 0 ? _blockSize : 1;
+    m_nextBlock = 0;
+    m_pending = m_threads.size();
+    ++m_generation;
+  }
+  m_wake.notify_all();
+  // the calling thread does its share rather than just waiting
+  runBlocks();
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_done.wait(lock, [this]{ return m_pending == 0; });
+  m_job = nullptr;
+}
+
+void WorkerPool::runBlocks()
+{
+  for (;;)
+  {
+    size_t begin = m_nextBlock.fetch_add(1)*m_blockSize;
+    if (begin >= m_count)
+    {
+      return;
+    }
+    size_t end = begin+m_blockSize < m_count ? begin+m_blockSize : m_count;
+    (*m_job)(begin, end);
+  }
+}
+
+void WorkerPool::worker()
+{
+  uint64_t seen = 0;
+  for (;;)
+  {
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_wake.wait(lock, [&]{ return m_quit || m_generation != seen; });
+      if (m_quit)
+      {
+        return;
+      }
+      seen = m_generation;
+    }
+    runBlocks();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (--m_pending == 0)
+    {
+      m_done.notify_one();
+    }
+  }
+}
@@ -0,0 +1,46 @@
+// a fixed set of threads that split a range of work into blocks
+#ifndef WORKERPOOL_H_
+#define WORKERPOOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkerPool
+{
+public:
+  // _threads is the total including the thread calling parallelFor
+  explicit WorkerPool(size_t _threads=std::thread::hardware_concurrency());
+  ~WorkerPool();
+  WorkerPool(const WorkerPool &)=delete;
+  WorkerPool &operator=(const WorkerPool &)=delete;
+
+  size_t size() const { return m_threads.size()+1; }
+  /// calls _f(begin,end) for each _blockSize block of [0,_count) and returns
+  /// once they have all finished. Blocks may run on any thread in any order so
+  /// _f must only touch its own block. Only one parallelFor may run at a time.
+  void parallelFor(size_t _count, size_t _blockSize, const std::function<void(size_t,size_t)> &_f);
+
+private:
+  void worker();
+  void runBlocks();
+  std::vector<std::thread> m_threads;
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::condition_variable m_done;
+  // the current job, only written under m_mutex while no workers are running it
+  const std::function<void(size_t,size_t)> *m_job = nullptr;
+  size_t m_count = 0;
+  size_t m_blockSize = 1;
+  std::atomic<size_t> m_nextBlock{0};
+  size_t m_pending = 0;
+  uint64_t m_generation = 0;
+  bool m_quit = false;
+};
+
+#endif
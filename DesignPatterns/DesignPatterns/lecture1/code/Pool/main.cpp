@@ -1,19 +1,147 @@
+#include "ObjectPool.h"
 #include "ParticlePool.h"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
 
-int main()
+// animate(WorkerPool &) has to leave the pool exactly as animate() would, the
+// same positions and the same free list order, which shows up as the order
+// create hands out the free slots
+static bool parallelMatchesSerial()
 {
-  ParticlePool pool;
-  for(int i=0; i<100; ++i)
+  constexpr size_t Size=10000;
+  ParticlePool<double> serial(Size);
+  ParticlePool<double> parallel(Size);
+  // emitters are deterministic so a copy feeds the second pool the same particles
+  Emitter emitter(0, 0, 1, 0.5);
+  emitter.setSpread(0.25);
+  emitter.setLifetime(1, 20);
+  Emitter copy = emitter;
+  WorkerPool workers(4);
+  for (int frame=0; frame<30; ++frame)
   {
-    pool.create(0, 0, 1, 1, 10);
-  //  pool.create(1, 0, 1, 1, 10);
-  //  pool.create(2, 0, 1, 1, 10);
+    serial.emit(emitter, 500);
+    parallel.emit(copy, 500);
+    serial.animate();
+    // small blocks so the deaths are spread over lots of chains
+    parallel.animate(workers, 256);
+    for (size_t i=0; i<Size; ++i)
+    {
+      const auto &a = serial.particle(i);
+      const auto &b = parallel.particle(i);
+      if (a.inUse() != b.inUse() || (a.inUse() && (a.x() != b.x() || a.y() != b.y())))
+      {
+        return false;
+      }
+    }
   }
-  while(1)
+  if (serial.liveCount() != parallel.liveCount())
   {
-    static int i=0;
+    return false;
+  }
+  for (;;)
+  {
+    auto *a = serial.create(0, 0, 0, 0, 1);
+    auto *b = parallel.create(0, 0, 0, 0, 1);
+    if (a == nullptr || b == nullptr)
+    {
+      return a == b;
+    }
+    if (a-&serial.particle(0) != b-&parallel.particle(0))
+    {
+      return false;
+    }
+  }
+}
+
+// particles asked for from inside a parallel loop go through the spawn queue
+// and are only created once the thread owning the pool commits them
+static bool workerSpawnsCommitted()
+{
+  constexpr size_t Work=4096;
+  constexpr size_t PerSpawn=16;
+  ParticlePool<double> pool(10000);
+  WorkerPool workers(4);
+  size_t spawned=0;
+  for (int frame=0; frame<10; ++frame)
+  {
+    workers.parallelFor(Work, 256, [&pool](size_t _begin, size_t _end)
+    {
+      for (size_t i=_begin; i<_end; i+=PerSpawn)
+      {
+        pool.spawn(double(i), 0, 0, 1, 100);
+      }
+    });
+    spawned += Work/PerSpawn;
+    // nothing lives less than 100 frames so every spawn is still alive
+    if (pool.commitSpawns() != Work/PerSpawn || pool.liveCount() != spawned)
+    {
+      return false;
+    }
     pool.animate();
-    pool.create(++i, 0, 1, 1, 10);
   }
+  return true;
+}
 
+// runs 1000 frames, pass a file name to export every frame and add --mmap to
+// write it through a mapping, the frames can be read back with PoolFrameReader
+int main(int argc, char **argv)
+{
+  if (!parallelMatchesSerial())
+  {
+    std::cerr<<"parallel animate differs from the serial one\n";
+    return EXIT_FAILURE;
+  }
+  if (!workerSpawnsCommitted())
+  {
+    std::cerr<<"spawns from the workers didn't all arrive\n";
+    return EXIT_FAILURE;
+  }
+  std::unique_ptr<FrameWriter> writer;
+  if (argc > 1)
+  {
+    auto mode = (argc > 2 && std::strcmp(argv[2], "--mmap") == 0) ? FrameWriter::Mode::MemoryMapped
+                                                                   : FrameWriter::Mode::Buffered;
+    writer.reset(new FrameWriter(argv[1], mode));
+    if (!writer->isOpen())
+    {
+      return EXIT_FAILURE;
+    }
+  }
+  ParticlePool<double> pool;
+  // fill the pool in one go rather than 100 separate creates
+  pool.create(100, 0, 0, 1, 1, 10);
+  // emitters come and go during the run so they live in an ObjectPool and
+  // are only referred to by handle
+  ObjectPool<Emitter,8> emitters;
+  PoolHandle fountain = emitters.create(0.0, 0.0, 0.0, 1.0, 5);
+  PoolHandle spray = emitters.create(10.0, 0.0, -1.0, 1.0, 5);
+  emitters.get(spray)->setSpread(0.5);
+  constexpr uint32_t Frames=1000;
+  for (uint32_t frame=0; frame<Frames; ++frame)
+  {
+    pool.animate();
+    if (writer && !pool.writeFrame(*writer, frame))
+    {
+      std::cerr<<"failed writing frame "<<frame<<" to "<<argv[1]<<'\n';
+      return EXIT_FAILURE;
+    }
+    emitters.forEach([&pool](Emitter &_e) { pool.emit(_e); });
+    if (frame == 500)
+    {
+      emitters.release(spray);
+    }
+  }
+  // the slot may be reused but the old handle no longer finds anything
+  if (emitters.get(spray) != nullptr || emitters.get(fountain) == nullptr)
+  {
+    return EXIT_FAILURE;
+  }
+  if (writer && !writer->close())
+  {
+    std::cerr<<"failed writing "<<argv[1]<<'\n';
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
 }
@@ -0,0 +1,292 @@
+// benchmark suite for the particle pools, the results are written to stdout as
+// JSON and progress goes to stderr so the two can be redirected separately
+//   PoolBenchmark [--max-size n] [--min-updates n] > results.json
+// build with something like
+// g++ -O3 -march=native -std=c++11 -pthread -I../Pool -I../BenchmarkCommon main.cpp ../Pool/Particle.cpp ../Pool/ParticlePool.cpp ../Pool/WorkerPool.cpp ../Pool/FrameStream.cpp ../Pool/Emitter.cpp ../Pool/ParticlePoolSoA.cpp ../Pool/SpawnQueue.cpp
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "Fixed16.h"
+#include "JsonRecord.h"
+#include "ParticlePool.h"
+#include "ParticlePoolSoA.h"
+#include "WorkerPool.h"
+
+using Clock = std::chrono::steady_clock;
+
+static double nsSince(Clock::time_point _start)
+{
+  return std::chrono::duration<double,std::nano>(Clock::now()-_start).count();
+}
+
+// the pool as it was before the free list, create has to look at every slot
+class ScanPool
+{
+public:
+  Particle<double> *create(double _x, double _y,double _xVel, double _yVel, int _lifetime)
+  {
+    for (auto &p : m_particles)
+    {
+      if (!p.inUse())
+      {
+        p.init(_x, _y, _xVel, _yVel, _lifetime);
+        return &p;
+      }
+    }
+    return nullptr;
+  }
+  void release(Particle<double> *_p) { _p->kill(); }
+private:
+  static constexpr int PoolSize = 100;
+  std::array<Particle<double>,PoolSize> m_particles;
+};
+
+template <typename Pool>
+void createReleasePairs(Pool &_pool, int _iterations)
+{
+  for (int i=0; i<_iterations; ++i)
+  {
+    Particle<double> *p = _pool.create(i, 0, 1, 1, 10);
+    if (p != nullptr)
+    {
+      _pool.release(p);
+    }
+  }
+}
+
+// fill the pool to _live particles then time create / release pairs so the
+// occupancy stays fixed for the whole run. An untimed pass first faults in the
+// pages and warms the caches so the order the pools run in doesn't matter.
+template <typename Pool>
+double nsPerCreate(int _live, int _iterations)
+{
+  Pool pool;
+  for (int i=0; i<_live; ++i)
+  {
+    pool.create(0, 0, 1, 1, 1000000);
+  }
+  createReleasePairs(pool, _iterations/10);
+  auto start = Clock::now();
+  createReleasePairs(pool, _iterations);
+  return nsSince(start)/_iterations;
+}
+
+// spawn _burst particles into an empty pool, _mode picks one create per
+// particle, create(n,...) or emit
+double nsPerBurstParticle(size_t _burst, int _mode, int _repeats)
+{
+  ParticlePool<double> pool(_burst);
+  Emitter emitter(0, 0, 1, 1);
+  emitter.setSpread(0.5);
+  double total=0.0;
+  for (int r=0; r<_repeats; ++r)
+  {
+    auto start = Clock::now();
+    switch (_mode)
+    {
+      case 0 :
+        for (size_t i=0; i<_burst; ++i)
+        {
+          pool.create(0, 0, 1, 1, 1);
+        }
+      break;
+      case 1 : pool.create(_burst, 0, 0, 1, 1, 1); break;
+      default : pool.emit(emitter, _burst); break;
+    }
+    total += nsSince(start);
+    // everything has a lifetime of 1 so this empties the pool again
+    pool.animate();
+  }
+  return total/(double(_burst)*_repeats);
+}
+
+// queue _burst spawns from every thread of _workers then commit them on this
+// one, the first round is an untimed warm up
+double nsPerSpawnedParticle(WorkerPool &_workers, size_t _burst, int _repeats)
+{
+  ParticlePool<double> pool(_burst);
+  double total=0.0;
+  for (int r=0; r<=_repeats; ++r)
+  {
+    auto start = Clock::now();
+    _workers.parallelFor(_burst, 1024, [&pool](size_t _begin, size_t _end)
+    {
+      for (size_t i=_begin; i<_end; ++i)
+      {
+        pool.spawn(double(i), 0, 1, 1, 1);
+      }
+    });
+    size_t created = pool.commitSpawns();
+    if (r > 0)
+    {
+      total += nsSince(start);
+    }
+    if (created != _burst)
+    {
+      std::cerr<<"only "<<created<<" of "<<_burst<<" spawns were created\n";
+    }
+    pool.animate();
+  }
+  return total/(double(_burst)*_repeats);
+}
+
+struct LifetimeRange
+{
+  const char *name;
+  int minFrames;
+  int maxFrames;
+};
+
+// Fill a pool of _capacity to _occupancy timing one create call per particle,
+// then run enough frames for at least _minUpdates particle updates topping
+// the pool back up to the same occupancy after each frame (not timed).
+template <typename Pool, typename T>
+std::string runCase(Pool &_pool, const char *_layout, const char *_scalar,
+                    double _occupancy, const LifetimeRange &_lifetime, size_t _minUpdates)
+{
+  size_t capacity = _pool.capacity();
+  size_t target = static_cast<size_t>(capacity*_occupancy);
+  Emitter emitter(0, 0, 1, 0.5);
+  emitter.setSpread(0.25);
+  emitter.setLifetime(_lifetime.minFrames, _lifetime.maxFrames);
+  SpawnBatch batch;
+  emitter.generate(target, batch);
+
+  auto start = Clock::now();
+  for (size_t i=0; i<target; ++i)
+  {
+    _pool.create(static_cast<T>(batch.x[i]), static_cast<T>(batch.y[i]),
+                 static_cast<T>(batch.xVel[i]), static_cast<T>(batch.yVel[i]), batch.lifetime[i]);
+  }
+  double createNs = target > 0 ? nsSince(start)/target : 0.0;
+
+  size_t frames = target > 0 ? (_minUpdates+target-1)/target : 1;
+  frames = frames < 3 ? 3 : (frames > 500 ? 500 : frames);
+  double animateNs = 0.0;
+  size_t liveUpdates = 0;
+  for (size_t f=0; f<frames; ++f)
+  {
+    liveUpdates += _pool.liveCount();
+    start = Clock::now();
+    _pool.animate();
+    animateNs += nsSince(start);
+    _pool.emit(emitter, target-_pool.liveCount());
+  }
+
+  JsonRecord r;
+  r.add("layout", _layout).add("scalar", _scalar).add("capacity", capacity)
+   .add("occupancy", _occupancy).add("lifetime", _lifetime.name).add("frames", frames)
+   .add("create_ns_per_particle", createNs)
+   .add("animate_ns_per_live_particle", liveUpdates > 0 ? animateNs/liveUpdates : 0.0)
+   .add("animate_ns_per_slot", animateNs/(double(capacity)*frames))
+   .add("memory_bytes", _pool.memoryBytes())
+   .add("memory_bytes_per_slot", double(_pool.memoryBytes())/capacity);
+  return r.str();
+}
+
+// the AoS pool animated on a WorkerPool, animate() is hidden so runCase
+// times the parallel version
+template <typename T>
+class ParallelParticlePool : public ParticlePool<T>
+{
+public:
+  ParallelParticlePool(size_t _capacity, WorkerPool &_workers) :
+    ParticlePool<T>(_capacity), m_workers(_workers) {}
+  void animate() { ParticlePool<T>::animate(m_workers); }
+private:
+  WorkerPool &m_workers;
+};
+
+template <typename T>
+void suite(const char *_scalar, size_t _maxSize, size_t _minUpdates, WorkerPool &_workers,
+           std::vector<std::string> &_records)
+{
+  const double occupancies[] = {0.1, 0.5, 0.99};
+  const LifetimeRange lifetimes[] = { {"constant_60", 60, 60}, {"uniform_1_120", 1, 120}, {"uniform_1_8", 1, 8} };
+  for (size_t size=100; size<=_maxSize; size*=10)
+  {
+    std::cerr<<_scalar<<" pools of "<<size<<'\n';
+    for (double occupancy : occupancies)
+    {
+      for (const auto &lifetime : lifetimes)
+      {
+        {
+          ParticlePool<T> pool(size);
+          _records.push_back(runCase<ParticlePool<T>,T>(pool, "aos", _scalar, occupancy, lifetime, _minUpdates));
+        }
+        {
+          ParallelParticlePool<T> pool(size, _workers);
+          _records.push_back(runCase<ParallelParticlePool<T>,T>(pool, "aos_parallel", _scalar, occupancy, lifetime, _minUpdates));
+        }
+        {
+          ParticlePoolSoA<T> pool(size);
+          _records.push_back(runCase<ParticlePoolSoA<T>,T>(pool, "soa", _scalar, occupancy, lifetime, _minUpdates));
+        }
+        {
+          ParticlePoolSoA<T> pool(size, ParticlePoolSoA<T>::Mode::Compact);
+          _records.push_back(runCase<ParticlePoolSoA<T>,T>(pool, "soa_compact", _scalar, occupancy, lifetime, _minUpdates));
+        }
+      }
+    }
+  }
+}
+
+int main(int argc, char **argv)
+{
+  size_t maxSize = 10000000;
+  size_t minUpdates = 20000000;
+  for (int i=1; i+1<argc; i+=2)
+  {
+    if (std::strcmp(argv[i], "--max-size") == 0)
+    {
+      maxSize = std::strtoull(argv[i+1], nullptr, 10);
+    }
+    else if (std::strcmp(argv[i], "--min-updates") == 0)
+    {
+      minUpdates = std::strtoull(argv[i+1], nullptr, 10);
+    }
+  }
+
+  std::cerr<<"create scan vs free list\n";
+  std::vector<std::string> createScan;
+  constexpr int iterations=10000000;
+  for (int live : {10, 50, 99})
+  {
+    JsonRecord r;
+    r.add("capacity", 100).add("live", live)
+     .add("scan_ns_per_create", nsPerCreate<ScanPool>(live, iterations))
+     .add("free_list_ns_per_create", nsPerCreate<ParticlePool<double>>(live, iterations));
+    createScan.push_back(r.str());
+  }
+
+  WorkerPool workers;
+  std::cerr<<"parallel cases use "<<workers.size()<<" threads\n";
+  std::cerr<<"bursts\n";
+  std::vector<std::string> bursts;
+  for (size_t burst : {1000, 10000, 100000})
+  {
+    JsonRecord r;
+    r.add("burst", burst)
+     .add("create_ns_per_particle", nsPerBurstParticle(burst, 0, 200))
+     .add("create_n_ns_per_particle", nsPerBurstParticle(burst, 1, 200))
+     .add("emit_ns_per_particle", nsPerBurstParticle(burst, 2, 200))
+     .add("spawn_commit_ns_per_particle", nsPerSpawnedParticle(workers, burst, 200));
+    bursts.push_back(r.str());
+  }
+
+  std::vector<std::string> pools;
+  suite<float>("float", maxSize, minUpdates, workers, pools);
+  suite<double>("double", maxSize, minUpdates, workers, pools);
+  suite<Fixed16>("fixed16", maxSize, minUpdates, workers, pools);
+
+  std::cout<<"{\n";
+  writeSection("create_scan", createScan, false);
+  writeSection("burst", bursts, false);
+  writeSection("pools", pools, true);
+  std::cout<<"}\n";
+  return EXIT_SUCCESS;
+}
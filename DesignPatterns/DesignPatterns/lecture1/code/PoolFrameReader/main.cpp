@@ -0,0 +1,45 @@
+// decodes a particle frame file written by FrameWriter
+// build with something like
+// g++ -O2 -std=c++11 -I../Pool main.cpp ../Pool/FrameStream.cpp
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include "FrameStream.h"
+
+int main(int argc, char **argv)
+{
+  if (argc < 2)
+  {
+    std::cerr<<"usage : PoolFrameReader frames.bin [--positions]\n";
+    return EXIT_FAILURE;
+  }
+  FrameReader reader(argv[1]);
+  if (!reader.isOpen())
+  {
+    std::cerr<<"not a particle frame file "<<argv[1]<<'\n';
+    return EXIT_FAILURE;
+  }
+  bool positions = argc > 2 && std::strcmp(argv[2], "--positions") == 0;
+  uint32_t frame;
+  std::vector<double> xy;
+  size_t frames=0;
+  while (reader.next(frame, xy))
+  {
+    std::cout<<"Frame "<<frame<<" particles "<<xy.size()/2<<'\n';
+    if (positions)
+    {
+      for (size_t i=0; i<xy.size(); i+=2)
+      {
+        std::cout<<"Particle "<<xy[i]<<" "<<xy[i+1]<<'\n';
+      }
+    }
+    ++frames;
+  }
+  std::cout<<frames<<" frames\n";
+  if (!reader.good())
+  {
+    std::cerr<<"stopped at a truncated or corrupt record\n";
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,173 @@
+#include "Codec.h"
+#include <cstring>
+
+namespace
+{
+  constexpr size_t MinMatch = 4;
+  // the last bytes are always literals so a match never reads past the end
+  constexpr size_t LastLiterals = 5;
+  constexpr size_t MaxOffset = 65535;
+  constexpr int HashBits = 14;
+
+  uint32_t read32(const uint8_t *_p)
+  {
+    uint32_t v;
+    std::memcpy(&v, _p, sizeof(v));
+    return v;
+  }
+
+  uint32_t hash(uint32_t _v)
+  {
+    return (_v*2654435761u) >> (32-HashBits);
+  }
+
+  // lengths of 15 or more spill into extra bytes of 255 and a remainder
+  uint8_t *writeLength(uint8_t *_op, size_t _length)
+  {
+    for (_length -= 15; _length >= 255; _length -= 255)
+    {
+      *_op++ = 255;
+    }
+    *_op++ = static_cast<uint8_t>(_length);
+    return _op;
+  }
+
+  uint8_t *writeSequence(uint8_t *_op, const uint8_t *_literals, size_t _literalCount, size_t _offset, size_t _matchLength)
+  {
+    uint8_t *token = _op++;
+    size_t match = _matchLength >= MinMatch ? _matchLength-MinMatch : 0;
+    *token = static_cast<uint8_t>(((_literalCount < 15 ? _literalCount : 15) << 4) | (match < 15 ? match : 15));
+    if (_literalCount >= 15)
+    {
+      _op = writeLength(_op, _literalCount);
+    }
+    if (_literalCount > 0)
+    {
+      std::memcpy(_op, _literals, _literalCount);
+      _op += _literalCount;
+    }
+    if (_matchLength == 0)
+    {
+      return _op;
+    }
+    *_op++ = static_cast<uint8_t>(_offset);
+    *_op++ = static_cast<uint8_t>(_offset >> 8);
+    if (match >= 15)
+    {
+      _op = writeLength(_op, match);
+    }
+    return _op;
+  }
+
+  bool readLength(const uint8_t *&_ip, const uint8_t *_end, size_t &_length)
+  {
+    uint8_t b;
+    do
+    {
+      if (_ip == _end)
+      {
+        return false;
+      }
+      b = *_ip++;
+      _length += b;
+    } while (b == 255);
+    return true;
+  }
+}
+
+void Codec::compress(const uint8_t *_src, size_t _size, std::vector<uint8_t> &_out)
+{
+  _out.resize(bound(_size));
+  uint8_t *op = _out.data();
+  size_t anchor=0;
+  if (_size > MinMatch+LastLiterals)
+  {
+    // the last position each hash of 4 bytes was seen, +1 so 0 means never
+    std::vector<uint32_t> table(size_t(1) << HashBits, 0);
+    size_t limit = _size-LastLiterals;
+    size_t i=0;
+    while (i+MinMatch <= limit)
+    {
+      uint32_t seq = read32(_src+i);
+      uint32_t &slot = table[hash(seq)];
+      size_t candidate = slot;
+      slot = static_cast<uint32_t>(i+1);
+      if (candidate == 0 || i+1-candidate > MaxOffset || read32(_src+candidate-1) != seq)
+      {
+        // step further the longer we go without a match so noise is cheap
+        i += 1+((i-anchor) >> 6);
+        continue;
+      }
+      size_t match = candidate-1;
+      size_t length = MinMatch;
+      while (i+length < limit && _src[match+length] == _src[i+length])
+      {
+        ++length;
+      }
+      op = writeSequence(op, _src+anchor, i-anchor, i-match, length);
+      i += length;
+      anchor = i;
+    }
+  }
+  op = writeSequence(op, _src+anchor, _size-anchor, 0, 0);
+  _out.resize(static_cast<size_t>(op-_out.data()));
+}
+
+bool Codec::decompress(const uint8_t *_src, size_t _size, uint8_t *_dst, size_t _dstSize)
+{
+  const uint8_t *ip = _src;
+  const uint8_t *end = _src+_size;
+  uint8_t *op = _dst;
+  uint8_t *opEnd = _dst+_dstSize;
+  while (ip < end)
+  {
+    uint8_t token = *ip++;
+    size_t literals = token >> 4;
+    if (literals == 15 && !readLength(ip, end, literals))
+    {
+      return false;
+    }
+    if (literals > size_t(end-ip) || literals > size_t(opEnd-op))
+    {
+      return false;
+    }
+    if (literals > 0)
+    {
+      std::memcpy(op, ip, literals);
+      op += literals;
+      ip += literals;
+    }
+    // the last sequence stops after its literals
+    if (ip == end)
+    {
+      break;
+    }
+    if (end-ip < 2)
+    {
+      return false;
+    }
+    size_t offset = ip[0] | (size_t(ip[1]) << 8);
+    ip += 2;
+    size_t length = token & 15;
+    if (length == 15 && !readLength(ip, end, length))
+    {
+      return false;
+    }
+    length += MinMatch;
+    if (offset == 0 || offset > size_t(op-_dst) || length > size_t(opEnd-op))
+    {
+      return false;
+    }
+    // an overlapping match repeats the last offset bytes, copy in chunks that
+    // double each time rather than a byte at a time
+    const uint8_t *match = op-offset;
+    while (length > 0)
+    {
+      size_t chunk = size_t(op-match) < length ? size_t(op-match) : length;
+      std::memcpy(op, match, chunk);
+      op += chunk;
+      length -= chunk;
+    }
+  }
+  return op == opEnd;
+}
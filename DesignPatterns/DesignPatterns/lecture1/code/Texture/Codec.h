@@ -0,0 +1,26 @@
+// A small LZ77 codec in the style of LZ4, lossless and with no dependencies.
+// It trades ratio for speed so textures can be kept compressed in memory and
+// unpacked on demand. The stream is a run of sequences, each a token byte
+// (literal count in the high nibble, match length - 4 in the low nibble, 15
+// meaning more length bytes follow), the literals, then a 2 byte little endian
+// offset back into the output. The last sequence has literals only.
+#ifndef CODEC_H_
+#define CODEC_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Codec
+{
+public:
+  // replaces the contents of _out
+  static void compress(const uint8_t *_src, size_t _size, std::vector<uint8_t> &_out);
+  // _dstSize must be the exact uncompressed size, false if the stream is
+  // corrupt or doesn't produce exactly that many bytes
+  static bool decompress(const uint8_t *_src, size_t _size, uint8_t *_dst, size_t _dstSize);
+  // worst case compressed size so _out never has to grow mid stream
+  static size_t bound(size_t _size) { return _size+_size/255+16; }
+};
+
+#endif
@@ -0,0 +1,145 @@
+#include "DiskCache.h"
+#include "MappedFile.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+  constexpr size_t HeaderSize = 4096;
+  constexpr uint32_t Version = 1;
+
+  struct Header
+  {
+    char magic[4];
+    uint32_t version;
+    uint64_t sourceSize;
+    int64_t sourceTime;
+    uint32_t width;
+    uint32_t height;
+    uint32_t channels;
+    uint32_t topDown;
+    uint64_t pixelBytes;
+    uint32_t nameLength;
+    // the source name follows so a hash collision can't give the wrong pixels
+  };
+
+  bool sourceInfo(const std::string &_source, uint64_t &_size, int64_t &_time)
+  {
+    std::error_code err;
+    _size = fs::file_size(_source, err);
+    if (err)
+    {
+      return false;
+    }
+    _time = static_cast<int64_t>(fs::last_write_time(_source, err).time_since_epoch().count());
+    return !err;
+  }
+
+  // FNV-1a, only needs to spread the names over the file names
+  uint64_t hashName(const std::string &_name)
+  {
+    uint64_t h = 14695981039346656037ull;
+    for (unsigned char c : _name)
+    {
+      h = (h ^ c)*1099511628211ull;
+    }
+    return h;
+  }
+}
+
+DiskCache::DiskCache(const std::string &_dir) : m_dir(_dir)
+{
+  std::error_code err;
+  fs::create_directories(m_dir, err);
+}
+
+std::string DiskCache::entryPath(const std::string &_source) const
+{
+  char hex[17];
+  std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(hashName(_source)));
+  return (fs::path(m_dir) / (std::string(hex)+".texcache")).string();
+}
+
+bool DiskCache::load(const std::string &_source, TGAImage &_image) const
+{
+  uint64_t size;
+  int64_t time;
+  if (!sourceInfo(_source, size, time))
+  {
+    return false;
+  }
+  // map the entry once, the header is checked in place and the same mapping
+  // then backs the image
+  MappedFile file;
+  if (!file.open(entryPath(_source)) || file.size() < HeaderSize)
+  {
+    return false;
+  }
+  const uint8_t *header = file.data();
+  Header h;
+  std::memcpy(&h, header, sizeof(h));
+  if (std::memcmp(h.magic, "TXDC", 4) != 0 || h.version != Version ||
+      h.sourceSize != size || h.sourceTime != time ||
+      h.nameLength != _source.size() || sizeof(h)+h.nameLength > HeaderSize ||
+      std::memcmp(header+sizeof(h), _source.data(), _source.size()) != 0)
+  {
+    return false;
+  }
+  return _image.loadRaw(std::move(file), HeaderSize, static_cast<int>(h.width), static_cast<int>(h.height),
+                        static_cast<int>(h.channels), h.topDown != 0);
+}
+
+bool DiskCache::store(const std::string &_source, const TGAImage &_image) const
+{
+  // zeroed so the padding between fields isn't written out as stack garbage
+  Header h;
+  std::memset(&h, 0, sizeof(h));
+  std::memcpy(h.magic, "TXDC", 4);
+  h.version = Version;
+  h.width = static_cast<uint32_t>(_image.width());
+  h.height = static_cast<uint32_t>(_image.height());
+  h.channels = static_cast<uint32_t>(_image.channels());
+  h.topDown = _image.topDown() ? 1 : 0;
+  h.pixelBytes = _image.pixelBytes();
+  h.nameLength = static_cast<uint32_t>(_source.size());
+  if (_image.pixels() == nullptr || sizeof(h)+_source.size() > HeaderSize ||
+      !sourceInfo(_source, h.sourceSize, h.sourceTime))
+  {
+    return false;
+  }
+  std::vector<char> header(HeaderSize, 0);
+  std::memcpy(header.data(), &h, sizeof(h));
+  std::memcpy(header.data()+sizeof(h), _source.data(), _source.size());
+
+  std::string path = entryPath(_source);
+  // unique per writer so two processes building the same entry don't collide
+  std::string temp = path+".tmp"+std::to_string(std::random_device()());
+  {
+    std::ofstream out(temp, std::ios::binary);
+    out.write(header.data(), HeaderSize);
+    out.write(reinterpret_cast<const char *>(_image.pixels()), static_cast<std::streamsize>(_image.pixelBytes()));
+    if (!out.flush())
+    {
+      out.close();
+      std::remove(temp.c_str());
+      return false;
+    }
+  }
+  std::error_code err;
+  fs::rename(temp, path, err);
+  if (err)
+  {
+    fs::remove(temp, err);
+    return false;
+  }
+  return true;
+}
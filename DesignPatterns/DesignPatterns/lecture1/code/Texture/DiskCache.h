@@ -0,0 +1,31 @@
+// A directory of decoded textures that survives between runs. Each entry is a
+// 4096 byte header followed by the pixels, so the pixels start on a page
+// boundary and can be mapped straight into a TGAImage with no copy. Entries
+// are keyed by a hash of the source name and checked against the source
+// file's size and modification time, a stale entry is just rebuilt.
+#ifndef DISKCACHE_H_
+#define DISKCACHE_H_
+
+#include <string>
+#include "TGA.h"
+
+class DiskCache
+{
+public:
+  // the directory is made if it doesn't exist
+  explicit DiskCache(const std::string &_dir);
+  const std::string &directory() const { return m_dir; }
+  // map the cached pixels for _source into _image, false if there is no
+  // entry or it is stale (or the source itself can't be found)
+  bool load(const std::string &_source, TGAImage &_image) const;
+  // save _image as the entry for _source. The entry is written to a temporary
+  // file and renamed into place so readers (in this or another process) only
+  // ever see a whole entry.
+  bool store(const std::string &_source, const TGAImage &_image) const;
+
+private:
+  std::string entryPath(const std::string &_source) const;
+  std::string m_dir;
+};
+
+#endif
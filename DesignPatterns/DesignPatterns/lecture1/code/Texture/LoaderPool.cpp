@@ -0,0 +1,50 @@
+#include "LoaderPool.h"
+
+LoaderPool::LoaderPool(size_t _threads)
+{
+  for (size_t i=0; i<(_threads > 0 ? _threads : 1); ++i)
+  {
+    m_threads.emplace_back(&LoaderPool::worker, this);
+  }
+}
+
+LoaderPool::~LoaderPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_quit = true;
+  }
+  m_wake.notify_all();
+  for (auto &t : m_threads)
+  {
+    t.join();
+  }
+}
+
+void LoaderPool::submit(std::function<void()> _task)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_tasks.push_back(std::move(_task));
+  }
+  m_wake.notify_one();
+}
+
+void LoaderPool::worker()
+{
+  for (;;)
+  {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_wake.wait(lock, [this]{ return m_quit || !m_tasks.empty(); });
+      if (m_tasks.empty())
+      {
+        return;
+      }
+      task = std::move(m_tasks.front());
+      m_tasks.pop_front();
+    }
+    task();
+  }
+}
@@ -0,0 +1,34 @@
+// a fixed set of background threads that run queued tasks in order
+#ifndef LOADERPOOL_H_
+#define LOADERPOOL_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class LoaderPool
+{
+public:
+  explicit LoaderPool(size_t _threads);
+  // anything still queued is run before the threads are joined
+  ~LoaderPool();
+  LoaderPool(const LoaderPool &)=delete;
+  LoaderPool &operator=(const LoaderPool &)=delete;
+
+  size_t size() const { return m_threads.size(); }
+  void submit(std::function<void()> _task);
+
+private:
+  void worker();
+  std::vector<std::thread> m_threads;
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::deque<std::function<void()>> m_tasks;
+  bool m_quit = false;
+};
+
+#endif
@@ -0,0 +1,101 @@
+#include "MappedFile.h"
+#include <cstdio>
+#include <utility>
+#if defined(__unix__) || defined(__APPLE__)
+  #define MAPPEDFILE_MMAP
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+  close();
+}
+
+MappedFile::MappedFile(MappedFile &&_other)
+{
+  *this = std::move(_other);
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&_other)
+{
+  if (this != &_other)
+  {
+    close();
+    // a vector's buffer stays put when it moves so m_data is still good
+    m_data = _other.m_data;
+    m_size = _other.m_size;
+    m_mapped = _other.m_mapped;
+    m_copy = std::move(_other.m_copy);
+    _other.m_data = nullptr;
+    _other.m_size = 0;
+    _other.m_mapped = false;
+    _other.m_copy.clear();
+  }
+  return *this;
+}
+
+bool MappedFile::open(const std::string &_fname)
+{
+  close();
+#ifdef MAPPEDFILE_MMAP
+  int fd = ::open(_fname.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    return false;
+  }
+  struct stat info;
+  if (::fstat(fd, &info) != 0)
+  {
+    ::close(fd);
+    return false;
+  }
+  m_size = static_cast<size_t>(info.st_size);
+  if (m_size != 0)
+  {
+    void *map = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED)
+    {
+      ::close(fd);
+      m_size = 0;
+      return false;
+    }
+    m_data = static_cast<const uint8_t *>(map);
+    m_mapped = true;
+  }
+  // the mapping keeps its own reference to the file
+  ::close(fd);
+  return true;
+#else
+  std::FILE *file = std::fopen(_fname.c_str(), "rb");
+  if (file == nullptr)
+  {
+    return false;
+  }
+  std::fseek(file, 0, SEEK_END);
+  long size = std::ftell(file);
+  std::fseek(file, 0, SEEK_SET);
+  m_copy.resize(size > 0 ? static_cast<size_t>(size) : 0);
+  m_size = std::fread(m_copy.data(), 1, m_copy.size(), file);
+  std::fclose(file);
+  m_data = m_copy.data();
+  return true;
+#endif
+}
+
+void MappedFile::close()
+{
+#ifdef MAPPEDFILE_MMAP
+  if (m_mapped)
+  {
+    ::munmap(const_cast<uint8_t *>(m_data), m_size);
+  }
+#endif
+  m_data = nullptr;
+  m_size = 0;
+  m_mapped = false;
+  m_copy.clear();
+  m_copy.shrink_to_fit();
+}
@@ -0,0 +1,39 @@
+// a read only view of a whole file, memory mapped where the platform allows
+// so the pages are shared with the page cache (and any other process mapping
+// the same file) rather than copied into our own heap
+#ifndef MAPPEDFILE_H_
+#define MAPPEDFILE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class MappedFile
+{
+public:
+  MappedFile()=default;
+  ~MappedFile();
+  MappedFile(const MappedFile &)=delete;
+  MappedFile &operator=(const MappedFile &)=delete;
+  // the mapping moves with the object, _other is left closed
+  MappedFile(MappedFile &&_other);
+  MappedFile &operator=(MappedFile &&_other);
+
+  // false if the file can't be opened, any previous file is closed either way
+  bool open(const std::string &_fname);
+  void close();
+  const uint8_t *data() const { return m_data; }
+  size_t size() const { return m_size; }
+  // true when data() points at mapped pages rather than a heap copy
+  bool isMapped() const { return m_mapped; }
+
+private:
+  const uint8_t *m_data = nullptr;
+  size_t m_size = 0;
+  bool m_mapped = false;
+  // only used where mmap is not available
+  std::vector<uint8_t> m_copy;
+};
+
+#endif
@@ -0,0 +1,159 @@
+#include "TGA.h"
+#include <cstring>
+#include <utility>
+
+namespace
+{
+  constexpr size_t HeaderSize = 18;
+  enum ImageType : uint8_t
+  {
+    TrueColour = 2,
+    Grey = 3,
+    TrueColourRLE = 10,
+    GreyRLE = 11
+  };
+}
+
+bool TGAImage::load(const std::string &_fname)
+{
+  clear();
+  if (!m_file.open(_fname) || m_file.size() < HeaderSize)
+  {
+    clear();
+    return false;
+  }
+  const uint8_t *h = m_file.data();
+  size_t idLength = h[0];
+  uint8_t colourMapType = h[1];
+  uint8_t type = h[2];
+  int width = h[12] | (h[13] << 8);
+  int height = h[14] | (h[15] << 8);
+  int bits = h[16];
+  bool topDown = (h[17] & 0x20) != 0;
+  bool grey = type == Grey || type == GreyRLE;
+  bool supported = colourMapType == 0 &&
+                   (type == TrueColour || type == Grey || type == TrueColourRLE || type == GreyRLE) &&
+                   (grey ? bits == 8 : (bits == 24 || bits == 32));
+  if (!supported || width == 0 || height == 0)
+  {
+    clear();
+    return false;
+  }
+  m_width = width;
+  m_height = height;
+  m_channels = bits/8;
+  m_topDown = topDown;
+  size_t offset = HeaderSize+idLength;
+  size_t available = m_file.size() > offset ? m_file.size()-offset : 0;
+  if (type == TrueColour || type == Grey)
+  {
+    // the pixels are already in the layout we want so just point at them
+    if (available < pixelBytes())
+    {
+      clear();
+      return false;
+    }
+    m_pixels = m_file.data()+offset;
+    return true;
+  }
+  if (!decodeRLE(m_file.data()+offset, available))
+  {
+    clear();
+    return false;
+  }
+  // nothing else needs the compressed data
+  m_file.close();
+  m_pixels = m_decoded.data();
+  return true;
+}
+
+bool TGAImage::loadRaw(MappedFile &&_file, size_t _offset, int _width, int _height, int _channels, bool _topDown)
+{
+  clear();
+  m_file = std::move(_file);
+  m_width = _width;
+  m_height = _height;
+  m_channels = _channels;
+  m_topDown = _topDown;
+  if (_width <= 0 || _height <= 0 || _channels <= 0 ||
+      m_file.data() == nullptr || m_file.size() < _offset || m_file.size()-_offset < pixelBytes())
+  {
+    clear();
+    return false;
+  }
+  m_pixels = m_file.data()+_offset;
+  return true;
+}
+
+// each packet starts with a byte, the top bit set means one pixel repeated
+// (low 7 bits + 1) times otherwise that many literal pixels follow
+bool TGAImage::decodeRLE(const uint8_t *_src, size_t _size)
+{
+  size_t total = pixelBytes();
+  size_t pixel = static_cast<size_t>(m_channels);
+  m_decoded.resize(total);
+  uint8_t *dst = m_decoded.data();
+  size_t out=0;
+  size_t in=0;
+  while (out < total)
+  {
+    if (in >= _size)
+    {
+      return false;
+    }
+    uint8_t packet = _src[in++];
+    size_t count = (packet & 0x7f)+1u;
+    // packets aren't meant to cross the end of the image, don't trust that
+    if (out+count*pixel > total)
+    {
+      count = (total-out)/pixel;
+    }
+    if (packet & 0x80)
+    {
+      if (in+pixel > _size)
+      {
+        return false;
+      }
+      for (size_t i=0; i<count; ++i)
+      {
+        std::memcpy(dst+out, _src+in, pixel);
+        out += pixel;
+      }
+      in += pixel;
+    }
+    else
+    {
+      if (in+count*pixel > _size)
+      {
+        return false;
+      }
+      std::memcpy(dst+out, _src+in, count*pixel);
+      out += count*pixel;
+      in += count*pixel;
+    }
+  }
+  return true;
+}
+
+void TGAImage::clear()
+{
+  m_file.close();
+  m_decoded.clear();
+  m_decoded.shrink_to_fit();
+  m_pixels = nullptr;
+  m_width = 0;
+  m_height = 0;
+  m_channels = 0;
+  m_topDown = false;
+}
+
+void TGAImage::adoptPixels(std::vector<uint8_t> &&_pixels, int _width, int _height, int _channels, bool _topDown)
+{
+  clear();
+  m_decoded = std::move(_pixels);
+  m_pixels = m_decoded.empty() ? nullptr : m_decoded.data();
+  m_width = _width;
+  m_height = _height;
+  m_channels = _channels;
+  m_topDown = _topDown;
+}
@@ -0,0 +1,50 @@
+// Truevision TGA loading. Uncompressed true colour and grey scale images
+// (types 2 and 3) are used straight from the mapped file with no copy, run
+// length encoded ones (types 10 and 11) are decoded into our own buffer.
+// Pixels are left as the file stores them, BGR(A) or grey, and rows start at
+// the bottom unless topDown() is set.
+#ifndef TGA_H_
+#define TGA_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+
+class TGAImage
+{
+public:
+  // false if the file is missing, truncated or a type we don't handle (colour
+  // mapped images), the image is left empty in that case
+  bool load(const std::string &_fname);
+  // take over _file and use the pixels already in our layout from _offset in
+  // it, no TGA header, false if the file is too short
+  bool loadRaw(MappedFile &&_file, size_t _offset, int _width, int _height, int _channels, bool _topDown);
+  void clear();
+  // use _pixels as the storage for an image of the given layout, it must be
+  // empty (keeping just the layout) or pixelBytes() long
+  void adoptPixels(std::vector<uint8_t> &&_pixels, int _width, int _height, int _channels, bool _topDown);
+
+  int width() const { return m_width; }
+  int height() const { return m_height; }
+  // bytes per pixel, 1, 3 or 4
+  int channels() const { return m_channels; }
+  bool topDown() const { return m_topDown; }
+  const uint8_t *pixels() const { return m_pixels; }
+  size_t pixelBytes() const { return size_t(m_width)*m_height*m_channels; }
+  // true if pixels() points into the mapped file rather than a decoded copy
+  bool isZeroCopy() const { return m_pixels != nullptr && m_decoded.empty(); }
+
+private:
+  bool decodeRLE(const uint8_t *_src, size_t _size);
+  MappedFile m_file;
+  std::vector<uint8_t> m_decoded;
+  const uint8_t *m_pixels = nullptr;
+  int m_width = 0;
+  int m_height = 0;
+  int m_channels = 0;
+  bool m_topDown = false;
+};
+
+#endif
@@ -1,39 +1,716 @@
 #include "Texture.h"
+#include "Codec.h"
+#include "DiskCache.h"
+#include "LoaderPool.h"
+#include "TextureAtlas.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <limits>
+#include <thread>
 
 //now we can use the static member variable
-std::unordered_map<std::string,Texture*> Texture::m_textures;
+std::array<Texture::Shard,Texture::ShardCount> Texture::m_shards;
+std::array<std::atomic<Texture::Entry **>,Texture::MaxIdChunks> Texture::m_ids{};
+std::atomic<uint32_t> Texture::m_nextId{0};
+std::mutex Texture::m_idMutex;
+std::atomic<uint64_t> Texture::m_misses{0};
+std::atomic<uint64_t> Texture::m_coalescedMisses{0};
+std::atomic<uint64_t> Texture::m_coldHits{0};
+std::array<std::atomic<uint64_t>,TextureStats::LatencyBuckets> Texture::m_missLatency{};
+std::shared_ptr<const DiskCache> Texture::m_diskCache;
+std::mutex Texture::m_diskCacheMutex;
+std::shared_ptr<TextureAtlas> Texture::m_currentAtlas;
+std::mutex Texture::m_atlasMutex;
+std::atomic<size_t> Texture::m_budget{std::numeric_limits<size_t>::max()};
+std::atomic<size_t> Texture::m_bytesResident{0};
 
+Texture::Texture(const std::string &_t, TextureId _id) :
+  m_name( _t ), m_id(_id)
+{
+  auto cache = diskCache();
+  if (cache == nullptr || !cache->load(m_name, m_image))
+  {
+    m_image.load(m_name);
+    // only worth keeping if it took decoding
+    if (cache != nullptr && m_image.pixels() != nullptr && !m_image.isZeroCopy())
+    {
+      cache->store(m_name, m_image);
+    }
+  }
+  auto atlas = Texture::atlas();
+  if (atlas != nullptr && atlas->insert(reinterpret_cast<uintptr_t>(this), m_image))
+  {
+    // keep just the layout, the pixels live in the atlas now
+    m_atlas = atlas;
+    m_image.adoptPixels(std::vector<uint8_t>(), m_image.width(), m_image.height(),
+                        m_image.channels(), m_image.topDown());
+  }
+  updateBytes();
+}
+
+Texture::~Texture()
+{
+  if (m_atlas != nullptr)
+  {
+    m_atlas->remove(reinterpret_cast<uintptr_t>(this));
+  }
+}
+
+bool Texture::atlasRegion(AtlasRegion &_region) const
+{
+  return m_atlas != nullptr && m_atlas->find(reinterpret_cast<uintptr_t>(this), _region);
+}
+
+void Texture::setAtlas(int _pageSize, int _maxTextureSize)
+{
+  std::shared_ptr<TextureAtlas> atlas;
+  if (_pageSize > 0 && _maxTextureSize > 0)
+  {
+    atlas = std::make_shared<TextureAtlas>(_pageSize, _maxTextureSize);
+  }
+  std::lock_guard<std::mutex> lock(m_atlasMutex);
+  m_currentAtlas = atlas;
+}
+
+std::shared_ptr<TextureAtlas> Texture::atlas()
+{
+  std::lock_guard<std::mutex> lock(m_atlasMutex);
+  return m_currentAtlas;
+}
+
+void Texture::setDiskCache(const std::string &_dir)
+{
+  std::shared_ptr<const DiskCache> cache;
+  if (!_dir.empty())
+  {
+    cache = std::make_shared<const DiskCache>(_dir);
+  }
+  std::lock_guard<std::mutex> lock(m_diskCacheMutex);
+  m_diskCache = cache;
+}
+
+std::shared_ptr<const DiskCache> Texture::diskCache()
+{
+  std::lock_guard<std::mutex> lock(m_diskCacheMutex);
+  return m_diskCache;
+}
+
+void Texture::updateBytes()
+{
+  // mapped pixels count too, dropping the texture unmaps them
+  m_bytes = sizeof(Texture)+m_name.capacity()+
+            (m_cold ? m_compressed.capacity() : (m_image.pixels() != nullptr ? m_image.pixelBytes() : 0));
+  if (m_atlas != nullptr)
+  {
+    // our share of the page
+    m_bytes += size_t(m_image.width())*m_image.height()*TextureAtlas::Channels;
+  }
+}
+
+bool Texture::compress(std::vector<uint8_t> &_out) const
+{
+  if (pixels() == nullptr)
+  {
+    return false;
+  }
+  Codec::compress(pixels(), m_image.pixelBytes(), _out);
+  // only worth it if it saves at least an eighth
+  if (_out.size() > m_image.pixelBytes()-m_image.pixelBytes()/8)
+  {
+    return false;
+  }
+  _out.shrink_to_fit();
+  return true;
+}
+
+Texture::Texture(const Texture &_from, std::vector<uint8_t> &&_pixels, std::vector<uint8_t> &&_packed) :
+  m_name(_from.m_name), m_id(_from.m_id), m_compressed(std::move(_packed))
+{
+  const TGAImage &layout = _from.m_image;
+  m_image.adoptPixels(std::move(_pixels), layout.width(), layout.height(), layout.channels(), layout.topDown());
+  m_cold = !m_compressed.empty();
+  updateBytes();
+}
+
+std::shared_ptr<Texture> Texture::makeCold(std::vector<uint8_t> &&_packed) const
+{
+  return std::shared_ptr<Texture>(new Texture(*this, std::vector<uint8_t>(), std::move(_packed)));
+}
+
+std::shared_ptr<Texture> Texture::makeHot() const
+{
+  std::vector<uint8_t> pixels(m_image.pixelBytes());
+  if (!Codec::decompress(m_compressed.data(), m_compressed.size(), pixels.data(), pixels.size()))
+  {
+    return nullptr;
+  }
+  return std::shared_ptr<Texture>(new Texture(*this, std::move(pixels), std::vector<uint8_t>()));
+}
+
+Texture::Entry *Texture::entryFor(TextureId _id)
+{
+  if (!_id.isValid() || _id.value() >= m_nextId.load(std::memory_order_acquire))
+  {
+    return nullptr;
+  }
+  Entry **chunk = m_ids[_id.value()/IdChunkSize].load(std::memory_order_acquire);
+  return chunk != nullptr ? chunk[_id.value()%IdChunkSize] : nullptr;
+}
+
+Texture::Entry *Texture::findOrAddEntry(Shard &_shard, size_t _shardIndex, const Key &_key)
+{
+  auto it = _shard.index.find(_key);
+  if (it != _shard.index.end())
+  {
+    return it->second;
+  }
+  // ids come from every shard so they are handed out under their own lock
+  std::lock_guard<std::mutex> lock(m_idMutex);
+  uint32_t id = m_nextId.load(std::memory_order_relaxed);
+  if (id/IdChunkSize >= MaxIdChunks)
+  {
+    return nullptr;
+  }
+  auto &chunk = m_ids[id/IdChunkSize];
+  if (chunk.load(std::memory_order_relaxed) == nullptr)
+  {
+    chunk.store(new Entry *[IdChunkSize](), std::memory_order_release);
+  }
+  Entry *e = new Entry;
+  e->name = std::string(_key.name);
+  e->hash = _key.hash;
+  e->id = TextureId(id);
+  e->shard = _shardIndex;
+  chunk.load(std::memory_order_relaxed)[id%IdChunkSize] = e;
+  // publish the slot before the id becomes visible to entryFor
+  m_nextId.store(id+1, std::memory_order_release);
+  _shard.index.emplace(Key{e->name, e->hash}, e);
+  return e;
+}
 
-Texture* Texture::getTexture(const std::string& _type)
+TextureId Texture::intern(std::string_view _type)
 {
-  // try to find an existing instance; if not found std::map will return types.end()
+  Key key = makeKey(_type);
+  size_t index = shardIndex(key);
+  Shard &shard = m_shards[index];
+  {
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.index.find(key);
+    if (it != shard.index.end())
+    {
+      return it->second->id;
+    }
+  }
+  std::unique_lock<std::shared_mutex> lock(shard.mutex);
+  Entry *e = findOrAddEntry(shard, index, key);
+  return e != nullptr ? e->id : TextureId();
+}
 
-  auto it = m_textures.find(_type);
-  Texture *t;
-  if (it == m_textures.end())
-  { // if no instance with the proper type was found, make one
-    t = new Texture(_type); // lazy initialization part
-  m_textures[_type] = t;
+// call with at least a shared lock on the entry's shard
+std::shared_ptr<Texture> Texture::hit(Entry &_entry)
+{
+  m_shards[_entry.shard].hits.fetch_add(1, std::memory_order_relaxed);
+  auto &t = _entry.texture;
+  // only write when it changes so hits don't bounce the cache line around
+  if (!t->m_referenced.load(std::memory_order_relaxed))
+  {
+    t->m_referenced.store(true, std::memory_order_relaxed);
+  }
+  return t; //The return value will be the found texture
+}
+
+std::shared_ptr<Texture> Texture::getTexture(std::string_view _type)
+{
+  Key key = makeKey(_type);
+  size_t index = shardIndex(key);
+  Shard &shard = m_shards[index];
+  // try to find an existing instance, readers can share the lock
+  {
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.index.find(key);
+    if (it != shard.index.end() && it->second->isHot())
+    { //if already had an instance
+      return hit(*it->second);
+    }
+  }
+  Entry *e;
+  std::shared_ptr<Promise> promise;
+  Future f = beginLoad(shard, index, key, e, promise);
+  return promise ? finishLoad(*e, *promise) : f.get();
+}
+
+std::shared_ptr<Texture> Texture::getTexture(TextureId _id)
+{
+  Entry *e = entryFor(_id);
+  if (e == nullptr)
+  {
+    return nullptr;
+  }
+  Shard &shard = m_shards[e->shard];
+  {
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    if (e->isHot())
+    {
+      return hit(*e);
+    }
+  }
+  std::shared_ptr<Promise> promise;
+  Future f = beginLoad(shard, e->shard, Key{e->name, e->hash}, e, promise);
+  return promise ? finishLoad(*e, *promise) : f.get();
+}
+
+Texture::Future Texture::getTextureAsync(std::string_view _type)
+{
+  Key key = makeKey(_type);
+  size_t index = shardIndex(key);
+  Shard &shard = m_shards[index];
+  {
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.index.find(key);
+    if (it != shard.index.end() && it->second->isHot())
+    {
+      return ready(hit(*it->second));
+    }
+  }
+  Entry *e;
+  std::shared_ptr<Promise> promise;
+  Future f = beginLoad(shard, index, key, e, promise);
+  return startAsync(e, promise, f);
+}
+
+Texture::Future Texture::getTextureAsync(TextureId _id)
+{
+  Entry *e = entryFor(_id);
+  if (e == nullptr)
+  {
+    return ready(nullptr);
+  }
+  Shard &shard = m_shards[e->shard];
+  {
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    if (e->isHot())
+    {
+      return ready(hit(*e));
+    }
+  }
+  std::shared_ptr<Promise> promise;
+  Future f = beginLoad(shard, e->shard, Key{e->name, e->hash}, e, promise);
+  return startAsync(e, promise, f);
+}
+
+Texture::Future Texture::ready(std::shared_ptr<Texture> _texture)
+{
+  Promise p;
+  p.set_value(std::move(_texture));
+  return p.get_future().share();
+}
+
+Texture::Future Texture::startAsync(Entry *_entry, const std::shared_ptr<Promise> &_promise, Future _future)
+{
+  if (_promise)
+  {
+    // made on first use so programs that never load async never start threads
+    static LoaderPool s_loader(std::max(1u, std::thread::hardware_concurrency()/2));
+    s_loader.submit([_entry, _promise]
+    {
+      try
+      {
+        finishLoad(*_entry, *_promise);
+      }
+      catch (...)
+      {
+        // already passed on through the future
+      }
+    });
+  }
+  return _future;
+}
+
+Texture::Future Texture::beginLoad(Shard &_shard, size_t _shardIndex, const Key &_key,
+                                   Entry *&_entry, std::shared_ptr<Promise> &_promise)
+{
+  std::unique_lock<std::shared_mutex> lock(_shard.mutex);
+  _entry = findOrAddEntry(_shard, _shardIndex, _key);
+  if (_entry == nullptr)
+  {
+    // out of ids, the caller still gets the texture but it isn't cached
+    lock.unlock();
+    static std::atomic<bool> s_warned{false};
+    if (!s_warned.exchange(true))
+    {
+      std::cerr << "Texture: all " << IdChunkSize*MaxIdChunks
+                << " names interned, further textures are loaded uncached\n";
+    }
+    m_misses.fetch_add(1, std::memory_order_relaxed);
+    return ready(std::shared_ptr<Texture>(new Texture(std::string(_key.name), TextureId())));
+  }
+  // another thread may have made it while we waited for the exclusive lock
+  if (_entry->isHot())
+  {
+    return ready(hit(*_entry));
+  }
+  (_entry->texture ? m_coldHits : m_misses).fetch_add(1, std::memory_order_relaxed);
+  // or be making it now
+  if (_entry->pending.valid())
+  {
+    m_coalescedMisses.fetch_add(1, std::memory_order_relaxed);
   }
   else
-  { //if already had an instance
-    t = it->second; //The return value will be the found texture
+  {
+    _promise = std::make_shared<Promise>();
+    _entry->pending = _promise->get_future().share();
+  }
+  return _entry->pending;
+}
+
+std::shared_ptr<Texture> Texture::finishLoad(Entry &_entry, Promise &_promise)
+{
+  Shard &shard = m_shards[_entry.shard];
+  auto start = std::chrono::steady_clock::now();
+  // a cold texture is unpacked rather than loaded, holding it pins it so it
+  // stays in the cache while we work on it
+  std::shared_ptr<Texture> cold;
+  {
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    cold = _entry.texture;
+  }
+  std::shared_ptr<Texture> t;
+  try
+  {
+    if (cold)
+    {
+      t = cold->makeHot();
+    }
+    if (!t)
+    {
+      // the entry name never changes so this needs no lock
+      t.reset(new Texture(_entry.name, _entry.id)); // lazy initialization part
+    }
+  }
+  catch (...)
+  {
+    // let the next request try again
+    {
+      std::unique_lock<std::shared_mutex> lock(shard.mutex);
+      _entry.pending = Future();
+    }
+    _promise.set_exception(std::current_exception());
+    throw;
+  }
+  {
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    if (_entry.texture)
+    {
+      // the hot copy takes the cold one's place in the clock
+      m_bytesResident -= _entry.texture->sizeInBytes();
+      _entry.texture = t;
+    }
+    else
+    {
+      _entry.texture = t;
+      shard.clock.push_back(&_entry);
+    }
+    _entry.pending = Future();
+    m_bytesResident += t->sizeInBytes();
+  }
+  recordMissLatency(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now()-start).count()));
+  _promise.set_value(t);
+  // we hold t so it can't be evicted to make room for itself
+  if (m_bytesResident > m_budget)
+  {
+    enforceBudget();
   }
   return t;
 }
 
+PreloadResult Texture::preload(const std::string &_manifest, size_t _threads,
+                               const std::function<void(size_t,size_t)> &_progress)
+{
+  auto start = std::chrono::steady_clock::now();
+  PreloadResult result;
+  std::ifstream file(_manifest);
+  std::vector<std::string> names;
+  std::string line;
+  while (std::getline(file, line))
+  {
+    // trim so hand edited manifests with stray spaces or CRLF still work
+    size_t first = line.find_first_not_of(" \t\r");
+    size_t last = line.find_last_not_of(" \t\r");
+    if (first == std::string::npos || line[first] == '#')
+    {
+      continue;
+    }
+    names.push_back(line.substr(first, last-first+1));
+  }
+  result.requested = names.size();
+
+  std::atomic<size_t> next{0};
+  std::atomic<size_t> failed{0};
+  std::mutex progressMutex;
+  size_t done=0;
+  auto work = [&]
+  {
+    for (size_t i=next++; i<names.size(); i=next++)
+    {
+      auto t = getTexture(names[i]);
+      // atlas textures have no pixels() of their own so go by the size
+      if (t == nullptr || t->width() == 0)
+      {
+        ++failed;
+      }
+      if (_progress)
+      {
+        std::lock_guard<std::mutex> lock(progressMutex);
+        _progress(++done, names.size());
+      }
+    }
+  };
+  if (_threads == 0)
+  {
+    _threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  // no point starting more threads than there are names
+  _threads = std::min(_threads, std::max<size_t>(names.size(), 1));
+  std::vector<std::thread> threads;
+  for (size_t i=1; i<_threads; ++i)
+  {
+    threads.emplace_back(work);
+  }
+  work();
+  for (auto &t : threads)
+  {
+    t.join();
+  }
+  result.failed = failed;
+  result.loaded = result.requested-result.failed;
+  result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+  return result;
+}
+
+void Texture::setMemoryBudget(size_t _bytes)
+{
+  m_budget = _bytes;
+  enforceBudget();
+}
+
+void Texture::enforceBudget()
+{
+  // start somewhere different each time so one shard doesn't take all the evictions
+  static std::atomic<size_t> s_start{0};
+  size_t start = s_start++;
+  for (size_t i=0; i<ShardCount && m_bytesResident > m_budget; ++i)
+  {
+    evictFrom(m_shards[(start+i) % ShardCount]);
+  }
+}
+
+// Classic CLOCK, a texture that has been used since the hand last passed gets
+// a second chance, one held outside the cache (use_count > 1) is pinned. We
+// hold the exclusive lock so nobody can take a new reference while we look.
+void Texture::evictFrom(Shard &_shard)
+{
+  std::unique_lock<std::shared_mutex> lock(_shard.mutex);
+  // three turns is enough to clear every referenced flag, compress and then
+  // evict whatever is left
+  size_t limit = 3*_shard.clock.size();
+  for (size_t scanned=0; scanned<limit && !_shard.clock.empty() && m_bytesResident > m_budget; ++scanned)
+  {
+    if (_shard.hand >= _shard.clock.size())
+    {
+      _shard.hand = 0;
+    }
+    Entry *e = _shard.clock[_shard.hand];
+    if (e->texture.use_count() > 1 || e->texture->m_referenced.exchange(false))
+    {
+      ++_shard.hand;
+      continue;
+    }
+    // compressing comes before evicting, if that isn't enough it will be
+    // evicted when the hand comes round again
+    std::vector<uint8_t> packed;
+    if (e->texture->residency() == Residency::Hot && e->texture->compress(packed))
+    {
+      demote(_shard, *e, std::move(packed));
+      ++_shard.hand;
+      continue;
+    }
+    m_bytesResident -= e->texture->sizeInBytes();
+    e->texture.reset();
+    _shard.evictions.fetch_add(1, std::memory_order_relaxed);
+    // fill the gap with the last entry, the hand stays put to look at it next
+    Entry *last = _shard.clock.back();
+    _shard.clock[_shard.hand] = last;
+    _shard.clock.pop_back();
+  }
+}
+
+void Texture::demote(Shard &_shard, Entry &_entry, std::vector<uint8_t> &&_packed)
+{
+  auto cold = _entry.texture->makeCold(std::move(_packed));
+  // it has just been judged idle so no second chance
+  cold->m_referenced = false;
+  m_bytesResident -= _entry.texture->sizeInBytes();
+  m_bytesResident += cold->sizeInBytes();
+  _entry.texture = std::move(cold);
+  _shard.demotions.fetch_add(1, std::memory_order_relaxed);
+}
+
+size_t Texture::compressIdle()
+{
+  size_t demoted=0;
+  for (auto &shard : m_shards)
+  {
+    // pick the candidates first and compress them without holding the lock,
+    // the pixels can still be read by anyone who picks the texture up meanwhile
+    std::vector<std::pair<Entry *,std::shared_ptr<Texture>>> idle;
+    {
+      std::shared_lock<std::shared_mutex> lock(shard.mutex);
+      for (auto e : shard.clock)
+      {
+        auto &t = e->texture;
+        if (t.use_count() == 1 && t->residency() == Residency::Hot &&
+            !t->m_referenced.exchange(false))
+        {
+          idle.emplace_back(e, t);
+        }
+      }
+    }
+    for (auto &candidate : idle)
+    {
+      std::vector<uint8_t> packed;
+      if (!candidate.second->compress(packed))
+      {
+        continue;
+      }
+      std::unique_lock<std::shared_mutex> lock(shard.mutex);
+      // still in the cache, held only by the cache and us and not used since
+      // we looked
+      Entry &e = *candidate.first;
+      if (e.texture == candidate.second && e.texture.use_count() == 2 && !e.texture->m_referenced)
+      {
+        demote(shard, e, std::move(packed));
+        ++demoted;
+      }
+    }
+  }
+  return demoted;
+}
+
+void Texture::recordMissLatency(uint64_t _us)
+{
+  // the bucket is the number of bits needed for _us
+  size_t bucket=0;
+  while (_us != 0 && bucket+1 < TextureStats::LatencyBuckets)
+  {
+    _us >>= 1;
+    ++bucket;
+  }
+  m_missLatency[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+TextureStats Texture::stats()
+{
+  TextureStats s;
+  for (auto &shard : m_shards)
+  {
+    s.hits += shard.hits.load(std::memory_order_relaxed);
+    s.evictions += shard.evictions.load(std::memory_order_relaxed);
+    s.demotions += shard.demotions.load(std::memory_order_relaxed);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    s.texturesResident += shard.clock.size();
+    for (auto e : shard.clock)
+    {
+      s.texturesCold += e->texture->residency() == Residency::Cold ? 1 : 0;
+    }
+  }
+  s.misses = m_misses.load(std::memory_order_relaxed);
+  s.coalescedMisses = m_coalescedMisses.load(std::memory_order_relaxed);
+  s.coldHits = m_coldHits.load(std::memory_order_relaxed);
+  for (size_t i=0; i<TextureStats::LatencyBuckets; ++i)
+  {
+    s.missLatencyUs[i] = m_missLatency[i].load(std::memory_order_relaxed);
+  }
+  s.bytesResident = m_bytesResident;
+  s.memoryBudget = m_budget;
+  s.namesInterned = m_nextId.load(std::memory_order_acquire);
+  return s;
+}
+
+void Texture::dumpStats(std::ostream &_out)
+{
+  TextureStats s = stats();
+  _out << "{\"hits\": " << s.hits
+       << ", \"cold_hits\": " << s.coldHits
+       << ", \"misses\": " << s.misses
+       << ", \"coalesced_misses\": " << s.coalescedMisses
+       << ", \"evictions\": " << s.evictions
+       << ", \"demotions\": " << s.demotions
+       << ", \"hit_rate\": " << s.hitRate()
+       << ", \"bytes_resident\": " << s.bytesResident
+       << ", \"memory_budget\": " << s.memoryBudget
+       << ", \"textures_resident\": " << s.texturesResident
+       << ", \"textures_cold\": " << s.texturesCold
+       << ", \"names_interned\": " << s.namesInterned
+       << ", \"miss_latency_us\": [";
+  // only the buckets that have something in them, each with its range
+  bool first=true;
+  for (size_t i=0; i<TextureStats::LatencyBuckets; ++i)
+  {
+    if (s.missLatencyUs[i] == 0)
+    {
+      continue;
+    }
+    uint64_t lo = i == 0 ? 0 : uint64_t(1) << (i-1);
+    _out << (first ? "" : ", ") << "{\"min\": " << lo;
+    if (i+1 < TextureStats::LatencyBuckets)
+    {
+      _out << ", \"max\": " << (uint64_t(1) << i);
+    }
+    _out << ", \"count\": " << s.missLatencyUs[i] << "}";
+    first = false;
+  }
+  _out << "]}";
+}
+
+void Texture::resetStats()
+{
+  for (auto &shard : m_shards)
+  {
+    shard.hits = 0;
+    shard.evictions = 0;
+    shard.demotions = 0;
+  }
+  m_misses = 0;
+  m_coalescedMisses = 0;
+  m_coldHits = 0;
+  for (auto &bucket : m_missLatency)
+  {
+    bucket = 0;
+  }
+}
+
 void Texture::printCurrentTexture()
 {
-  if (!m_textures.empty())
+  size_t count=0;
+  for (auto &shard : m_shards)
+  {
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    count += shard.clock.size();
+  }
+  if (count != 0)
   {
-    std::cout << "Number of instances made = " << m_textures.size() << std::endl;
-//    for (std::map<std::string,Texture*>::iterator iter = m_textures.begin(); iter != m_textures.end(); ++iter)
-//    {
-//        std::cout << (*iter).first << std::endl;
-//    }
-    for (auto t : m_textures )
-      std::cout << t.first << std::endl;
+    std::cout << "Number of instances made = " << count << std::endl;
+    std::cout << "Bytes resident = " << bytesResident() << std::endl;
+    for (auto &shard : m_shards)
+    {
+      std::shared_lock<std::shared_mutex> lock(shard.mutex);
+      for (auto e : shard.clock )
+        std::cout << e->name << std::endl;
+    }
     std::cout << std::endl;
   }
 }
@@ -1,21 +1,276 @@
 #ifndef TEXTURE_H__
 #define TEXTURE_H__
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
+#include "TGA.h"
+
+class DiskCache;
+class TextureAtlas;
+struct AtlasRegion;
+
+// an interned texture name, resolve the name once with Texture::intern and
+// the id can then be used for lookups with no hashing or string handling
+class TextureId
+{
+public:
+  TextureId()=default;
+  explicit TextureId(uint32_t _value) : m_value(_value) {}
+  bool isValid() const { return m_value != Invalid; }
+  uint32_t value() const { return m_value; }
+  bool operator==(TextureId _rhs) const { return m_value == _rhs.m_value; }
+  bool operator!=(TextureId _rhs) const { return m_value != _rhs.m_value; }
+private:
+  static constexpr uint32_t Invalid = 0xffffffffu;
+  uint32_t m_value = Invalid;
+};
+
+// a point in time copy of the cache counters, see Texture::stats
+struct TextureStats
+{
+  static constexpr size_t LatencyBuckets = 32;
+  uint64_t hits = 0;
+  // found in the cache but compressed so it had to be unpacked
+  uint64_t coldHits = 0;
+  // every lookup that didn't find the texture loaded, coalescedMisses of them
+  // waited on a load someone else had already started
+  uint64_t misses = 0;
+  uint64_t coalescedMisses = 0;
+  uint64_t evictions = 0;
+  // textures moved to the compressed tier, by compressIdle or the budget
+  uint64_t demotions = 0;
+  size_t bytesResident = 0;
+  size_t memoryBudget = 0;
+  size_t texturesResident = 0;
+  // how many of texturesResident are compressed
+  size_t texturesCold = 0;
+  size_t namesInterned = 0;
+  // time to load on a miss or unpack on a cold hit, bucket 0 is under 1us and bucket i >= 1 counts
+  // loads that took [2^(i-1), 2^i) microseconds (the last is open ended)
+  std::array<uint64_t,LatencyBuckets> missLatencyUs{};
+  double hitRate() const
+  {
+    uint64_t total = hits+coldHits+misses;
+    return total > 0 ? double(hits+coldHits)/double(total) : 0.0;
+  }
+};
+
+// what Texture::preload did
+struct PreloadResult
+{
+  size_t requested = 0;
+  // textures that loaded with a size, whether they kept their own pixels or
+  // were packed into the atlas
+  size_t loaded = 0;
+  // names whose file couldn't be read, they are still cached as empty (0x0)
+  // textures
+  size_t failed = 0;
+  double seconds = 0.0;
+};
 
 class Texture
 {
 public :
-  static Texture* getTexture(const std::string &_type);
+  using Future = std::shared_future<std::shared_ptr<Texture>>;
+  // Cold textures keep their pixels compressed with Codec and are unpacked
+  // on the next lookup, every texture handed out by the lookups is Hot
+  enum class Residency { Hot, Cold };
+  ~Texture();
+  // safe to call from any number of threads at once, the texture stays pinned
+  // in the cache for as long as the returned pointer (or a copy) is held.
+  // string literals and std::string both convert to string_view without allocating.
+  // Every name looked up is interned (see intern), once the id table is full
+  // new names are still loaded but into a texture of their own that isn't
+  // cached, so this never returns nullptr.
+  static std::shared_ptr<Texture> getTexture(std::string_view _type);
+  // returns nullptr for an id that didn't come from intern
+  static std::shared_ptr<Texture> getTexture(TextureId _id);
+  // the same lookups but a miss is loaded on a background thread rather than
+  // blocking the caller. Requests for a texture that is already loading
+  // (async or not) share the one load. A hit returns a ready future.
+  static Future getTextureAsync(std::string_view _type);
+  static Future getTextureAsync(TextureId _id);
+  // Warm the cache from a manifest, a text file with one texture name per line
+  // (blank lines and lines starting with # are skipped). The names are loaded
+  // across _threads threads (0 for one per core) including the caller and
+  // preload returns when they are all done. _progress, if given, is called
+  // after each load with the number done so far and the total, one call at a
+  // time but from any of the loading threads. A manifest that can't be opened
+  // requests nothing.
+  static PreloadResult preload(const std::string &_manifest, size_t _threads=0,
+                               const std::function<void(size_t,size_t)> &_progress=nullptr);
+  // the id for a name, stays valid (and the same) for the life of the
+  // process even if the texture itself is evicted. Doesn't load anything.
+  // Interned names are never freed and there is room for 16M of them
+  // (IdChunkSize*MaxIdChunks), after that an invalid id is returned.
+  static TextureId intern(std::string_view _type);
+  // once the cache holds more than _bytes unpinned textures are compressed and
+  // then evicted, least recently used first (CLOCK approximation)
+  static void setMemoryBudget(size_t _bytes);
+  // keep decoded copies of compressed (RLE) files in _dir so later runs can map
+  // them instead of decoding again, an empty _dir turns it off (the default).
+  // Uncompressed files are mapped in place already so aren't copied.
+  static void setDiskCache(const std::string &_dir);
+  // Textures no bigger than _maxTextureSize either way are copied into shared
+  // _pageSize square atlas pages and keep no pixels of their own, 0 turns it
+  // off (the default). Textures already loaded stay as they are.
+  static void setAtlas(int _pageSize, int _maxTextureSize);
+  static std::shared_ptr<TextureAtlas> atlas();
+  // compress every unpinned texture that hasn't been used since the last call
+  // (or since the clock hand last passed), returns how many were compressed
+  static size_t compressIdle();
+  static size_t memoryBudget() { return m_budget; }
+  static size_t bytesResident() { return m_bytesResident; }
+  // the counters are updated with relaxed atomics so a snapshot taken while
+  // other threads are busy is only approximately consistent
+  static TextureStats stats();
+  // stats() as a JSON object
+  static void dumpStats(std::ostream &_out);
+  // zero the counters, the resident figures are left alone
+  static void resetStats();
   // just to demo the process
   static void printCurrentTexture();
+
+  // the name is the path of a TGA file, one that can't be read gives an
+  // empty texture (no pixels and a size of 0x0)
+  const std::string &name() const { return m_name; }
+  int width() const { return m_image.width(); }
+  int height() const { return m_image.height(); }
+  int channels() const { return m_image.channels(); }
+  // see TGAImage for the layout, uncompressed files are used in place
+  const uint8_t *pixels() const { return m_image.pixels(); }
+  const TGAImage &image() const { return m_image; }
+  TextureId id() const { return m_id; }
+  // an atlas texture has no pixels(), its pixels are in the atlas page as BGRA
+  bool inAtlas() const { return m_atlas != nullptr; }
+  // false if the texture isn't in an atlas
+  bool atlasRegion(AtlasRegion &_region) const;
+  Residency residency() const { return m_cold ? Residency::Cold : Residency::Hot; }
+  size_t sizeInBytes() const { return m_bytes; }
 private :
-    static std::unordered_map<std::string,Texture*> m_textures;
+    // a name with its hash worked out once, the high bits of the hash pick the
+    // shard and the shard's map reuses the whole hash rather than hashing the
+    // name again
+    struct Key
+    {
+      std::string_view name;
+      size_t hash;
+      bool operator==(const Key &_rhs) const { return hash == _rhs.hash && name == _rhs.name; }
+    };
+    struct KeyHash
+    {
+      size_t operator()(const Key &_key) const { return _key.hash; }
+    };
+    static Key makeKey(std::string_view _type) { return Key{_type, std::hash<std::string_view>()(_type)}; }
+    // Every name ever asked for gets an Entry which is never freed, so its
+    // name can key the shard index and its address can back a TextureId.
+    struct Entry
+    {
+      std::string name;
+      // of name, kept so lookups by id never hash
+      size_t hash;
+      TextureId id;
+      size_t shard;
+      // null when not loaded, guarded by the shard mutex
+      std::shared_ptr<Texture> texture;
+      // valid while a load is in flight, guarded by the shard mutex
+      Future pending;
+      bool isHot() const { return texture && !texture->m_cold; }
+    };
+    // The cache is split into shards by name hash, each with its own lock.
+    // A hit only takes a shared lock on one shard and a miss only blocks
+    // lookups in that shard while the texture is made.
+    static constexpr size_t ShardCount = 16;
+    // aligned so two shards never share a cache line
+    struct alignas(64) Shard
+    {
+      std::shared_mutex mutex;
+      // the keys are views of Entry::name so finding one never allocates
+      std::unordered_map<Key,Entry *,KeyHash> index;
+      // the loaded entries in no particular order, swept by the clock hand
+      std::vector<Entry *> clock;
+      size_t hand=0;
+      // kept per shard so hits on different shards don't share a counter
+      std::atomic<uint64_t> hits{0};
+      std::atomic<uint64_t> evictions{0};
+      std::atomic<uint64_t> demotions{0};
+    };
+    static std::array<Shard,ShardCount> m_shards;
+    // use the high bits, the low ones also pick the bucket inside the shard
+    static size_t shardIndex(const Key &_key) { return (_key.hash >> 24) % ShardCount; }
+    // find or add the entry for a name, call with the shard exclusively locked
+    static Entry *findOrAddEntry(Shard &_shard, size_t _shardIndex, const Key &_key);
+    using Promise = std::promise<std::shared_ptr<Texture>>;
+    // The slow path of both lookups. Returns the texture or the load already in
+    // flight for it, otherwise starts one and sets _promise which the caller
+    // must then pass to finishLoad. No lock is held while a texture is made.
+    static Future beginLoad(Shard &_shard, size_t _shardIndex, const Key &_key,
+                            Entry *&_entry, std::shared_ptr<Promise> &_promise);
+    static std::shared_ptr<Texture> finishLoad(Entry &_entry, Promise &_promise);
+    static Future startAsync(Entry *_entry, const std::shared_ptr<Promise> &_promise, Future _future);
+    static Future ready(std::shared_ptr<Texture> _texture);
+    static std::shared_ptr<Texture> hit(Entry &_entry);
+    // id to Entry, a table of fixed size chunks so it never moves and can be
+    // read without a lock
+    static constexpr size_t IdChunkSize = 4096;
+    static constexpr size_t MaxIdChunks = 4096;
+    static std::array<std::atomic<Entry **>,MaxIdChunks> m_ids;
+    static std::atomic<uint32_t> m_nextId;
+    static std::mutex m_idMutex;
+    static Entry *entryFor(TextureId _id);
+    // evict from the shards in turn until we are back under budget
+    static void enforceBudget();
+    static void evictFrom(Shard &_shard);
+    // Textures never change once made so holders can read them without
+    // locks, going hot or cold swaps the entry to a new copy instead
+    static void demote(Shard &_shard, Entry &_entry, std::vector<uint8_t> &&_packed);
+    // false if there are no pixels or they don't compress well enough to bother
+    bool compress(std::vector<uint8_t> &_out) const;
+    // a copy holding _packed in place of the pixels
+    std::shared_ptr<Texture> makeCold(std::vector<uint8_t> &&_packed) const;
+    // the unpacked copy of a cold texture, null if the packed pixels are bad
+    std::shared_ptr<Texture> makeHot() const;
+    void updateBytes();
+    static void recordMissLatency(uint64_t _us);
+    static std::atomic<uint64_t> m_misses;
+    static std::atomic<uint64_t> m_coalescedMisses;
+    static std::atomic<uint64_t> m_coldHits;
+    static std::array<std::atomic<uint64_t>,TextureStats::LatencyBuckets> m_missLatency;
+    static std::shared_ptr<const DiskCache> diskCache();
+    static std::shared_ptr<const DiskCache> m_diskCache;
+    static std::mutex m_diskCacheMutex;
+    static std::shared_ptr<TextureAtlas> m_currentAtlas;
+    static std::mutex m_atlasMutex;
+    static std::atomic<size_t> m_budget;
+    static std::atomic<size_t> m_bytesResident;
     // the type of this texture (i.e. the name)
     std::string m_name;
+    TextureId m_id;
+    TGAImage m_image;
+    // the pixels while cold
+    std::vector<uint8_t> m_compressed;
+    bool m_cold = false;
+    // the atlas holding our pixels, our region is freed when we go
+    std::shared_ptr<TextureAtlas> m_atlas;
+    size_t m_bytes;
+    // set on every hit and cleared as the clock hand passes
+    std::atomic<bool> m_referenced{true};
 
   // note: constructor private forcing one to use static getTexture()
-    Texture(const std::string &_t) : m_name( _t ) {}
+    Texture(const std::string &_t, TextureId _id);
+    // a copy of _from's name and layout with the given storage
+    Texture(const Texture &_from, std::vector<uint8_t> &&_pixels, std::vector<uint8_t> &&_packed);
 };
 
 #endif
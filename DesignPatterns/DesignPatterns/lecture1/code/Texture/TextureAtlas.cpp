@@ -0,0 +1,237 @@
+#include "TextureAtlas.h"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+  // a gap between textures so filtering at the edges doesn't pick up the neighbours
+  constexpr int Padding = 1;
+
+  // one source row to BGRA
+  void convertRow(const uint8_t *_src, int _channels, int _width, uint8_t *_dst)
+  {
+    for (int i=0; i<_width; ++i, _dst+=TextureAtlas::Channels)
+    {
+      switch (_channels)
+      {
+        case 1 : _dst[0] = _dst[1] = _dst[2] = _src[i]; _dst[3] = 255; break;
+        case 3 : std::memcpy(_dst, _src+3*i, 3); _dst[3] = 255; break;
+        default : std::memcpy(_dst, _src+4*i, 4); break;
+      }
+    }
+  }
+}
+
+TextureAtlas::TextureAtlas(int _pageSize, int _maxTextureSize) :
+  m_pageSize(_pageSize),
+  m_maxTextureSize(std::min(_maxTextureSize, _pageSize-Padding))
+{
+}
+
+bool TextureAtlas::fits(int _width, int _height) const
+{
+  return _width > 0 && _height > 0 && _width <= m_maxTextureSize && _height <= m_maxTextureSize;
+}
+
+// best fit shelf, the shortest one the texture fits on with room left, otherwise
+// start a new shelf under the last
+bool TextureAtlas::place(Page &_page, int _width, int _height, int &_x, int &_y) const
+{
+  int w = _width+Padding;
+  int h = _height+Padding;
+  Shelf *best = nullptr;
+  for (auto &shelf : _page.shelves)
+  {
+    if (shelf.height >= h && shelf.x+w <= m_pageSize && (best == nullptr || shelf.height < best->height))
+    {
+      best = &shelf;
+    }
+  }
+  if (best == nullptr)
+  {
+    if (_page.nextShelfY+h > m_pageSize)
+    {
+      return false;
+    }
+    _page.shelves.push_back({_page.nextShelfY, h, 0});
+    _page.nextShelfY += h;
+    best = &_page.shelves.back();
+  }
+  _x = best->x;
+  _y = best->y;
+  best->x += w;
+  _page.usedArea += size_t(_width)*_height;
+  _page.liveArea += size_t(_width)*_height;
+  return true;
+}
+
+bool TextureAtlas::insert(Key _key, const TGAImage &_image)
+{
+  if (_image.pixels() == nullptr || !fits(_image.width(), _image.height()))
+  {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_slots.count(_key) != 0)
+  {
+    return false;
+  }
+  Slot slot{0, 0, 0, _image.width(), _image.height()};
+  bool placed=false;
+  for (size_t i=0; i<m_pages.size() && !placed; ++i)
+  {
+    placed = place(m_pages[i], slot.width, slot.height, slot.x, slot.y);
+    slot.page = i;
+  }
+  if (!placed)
+  {
+    m_pages.emplace_back();
+    slot.page = m_pages.size()-1;
+    place(m_pages.back(), slot.width, slot.height, slot.x, slot.y);
+  }
+  Page &page = m_pages[slot.page];
+  // pages emptied by removals give their memory back so allocate on demand
+  if (page.pixels.empty())
+  {
+    page.pixels.assign(size_t(m_pageSize)*m_pageSize*Channels, 0);
+  }
+  size_t rowBytes = size_t(slot.width)*_image.channels();
+  for (int row=0; row<slot.height; ++row)
+  {
+    // flip bottom up images as we go
+    int srcRow = _image.topDown() ? row : slot.height-1-row;
+    convertRow(_image.pixels()+srcRow*rowBytes, _image.channels(), slot.width,
+               &page.pixels[(size_t(slot.y+row)*m_pageSize+slot.x)*Channels]);
+  }
+  m_slots.emplace(_key, slot);
+  return true;
+}
+
+void TextureAtlas::remove(Key _key)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_slots.find(_key);
+  if (it == m_slots.end())
+  {
+    return;
+  }
+  size_t index = it->second.page;
+  Page &page = m_pages[index];
+  page.liveArea -= size_t(it->second.width)*it->second.height;
+  m_slots.erase(it);
+  if (page.liveArea == 0)
+  {
+    // nothing left so just start the page again
+    page = Page{std::vector<uint8_t>(), {}, 0, 0, 0, page.generation+1};
+  }
+  else if (fragmentation(page) > RepackThreshold)
+  {
+    repack(index);
+  }
+}
+
+// Place the survivors again tallest first (which packs shelves best) into a
+// fresh buffer. Only this page is touched so regions on other pages stay put.
+void TextureAtlas::repack(size_t _page)
+{
+  Page &old = m_pages[_page];
+  std::vector<Slot *> slots;
+  for (auto &s : m_slots)
+  {
+    if (s.second.page == _page)
+    {
+      slots.push_back(&s.second);
+    }
+  }
+  std::sort(slots.begin(), slots.end(), [](const Slot *_a, const Slot *_b)
+  {
+    return _a->height != _b->height ? _a->height > _b->height : _a->width > _b->width;
+  });
+  // work out the new places first, a different order packing worse than the
+  // old one is unlikely but then we just keep the holes
+  Page fresh;
+  std::vector<std::pair<int,int>> places(slots.size());
+  for (size_t i=0; i<slots.size(); ++i)
+  {
+    if (!place(fresh, slots[i]->width, slots[i]->height, places[i].first, places[i].second))
+    {
+      return;
+    }
+  }
+  fresh.generation = old.generation+1;
+  fresh.pixels.assign(old.pixels.size(), 0);
+  for (size_t i=0; i<slots.size(); ++i)
+  {
+    Slot &s = *slots[i];
+    for (int row=0; row<s.height; ++row)
+    {
+      std::memcpy(&fresh.pixels[(size_t(places[i].second+row)*m_pageSize+places[i].first)*Channels],
+                  &old.pixels[(size_t(s.y+row)*m_pageSize+s.x)*Channels],
+                  size_t(s.width)*Channels);
+    }
+    s.x = places[i].first;
+    s.y = places[i].second;
+  }
+  old = std::move(fresh);
+}
+
+bool TextureAtlas::find(Key _key, AtlasRegion &_region) const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_slots.find(_key);
+  if (it == m_slots.end())
+  {
+    return false;
+  }
+  const Slot &s = it->second;
+  float scale = 1.0f/m_pageSize;
+  _region.page = s.page;
+  _region.generation = m_pages[s.page].generation;
+  _region.x = s.x;
+  _region.y = s.y;
+  _region.width = s.width;
+  _region.height = s.height;
+  _region.u0 = s.x*scale;
+  _region.v0 = s.y*scale;
+  _region.u1 = (s.x+s.width)*scale;
+  _region.v1 = (s.y+s.height)*scale;
+  return true;
+}
+
+size_t TextureAtlas::pageCount() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_pages.size();
+}
+
+void TextureAtlas::withPage(size_t _page, const std::function<void(const uint8_t *,int,uint64_t)> &_f) const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (_page < m_pages.size())
+  {
+    const Page &page = m_pages[_page];
+    _f(page.pixels.empty() ? nullptr : page.pixels.data(), m_pageSize, page.generation);
+  }
+}
+
+float TextureAtlas::fragmentation(const Page &_page) const
+{
+  return _page.usedArea > 0 ? 1.0f-float(_page.liveArea)/float(_page.usedArea) : 0.0f;
+}
+
+float TextureAtlas::fragmentation(size_t _page) const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return _page < m_pages.size() ? fragmentation(m_pages[_page]) : 0.0f;
+}
+
+size_t TextureAtlas::memoryBytes() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  size_t bytes = sizeof(*this)+m_slots.size()*(sizeof(Slot)+sizeof(Key));
+  for (auto &page : m_pages)
+  {
+    bytes += sizeof(Page)+page.pixels.capacity()+page.shelves.capacity()*sizeof(Shelf);
+  }
+  return bytes;
+}
@@ -0,0 +1,100 @@
+// Packs many small textures into a few large shared pages. Each page is
+// filled with a shelf packer, rows of shelves each as tall as the first
+// texture put on them. Space freed when a texture goes isn't reused in place,
+// instead a page is repacked once too much of it is holes.
+#ifndef TEXTUREATLAS_H_
+#define TEXTUREATLAS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "TGA.h"
+
+// where a texture is in the atlas, in pixels and as UVs with (0,0) at the top
+// left of the page. Repacking moves things so a region is only good while the
+// page generation is unchanged.
+struct AtlasRegion
+{
+  size_t page = 0;
+  uint64_t generation = 0;
+  int x = 0;
+  int y = 0;
+  int width = 0;
+  int height = 0;
+  float u0 = 0.0f;
+  float v0 = 0.0f;
+  float u1 = 0.0f;
+  float v1 = 0.0f;
+};
+
+class TextureAtlas
+{
+public:
+  // pages are always BGRA with the rows top down whatever the source was
+  static constexpr int Channels = 4;
+  // a page is repacked once more than this fraction of its used area is holes
+  static constexpr float RepackThreshold = 0.5f;
+  // anything unique to the owner of a region, Texture uses its own address
+  using Key = uint64_t;
+  explicit TextureAtlas(int _pageSize=2048, int _maxTextureSize=128);
+  TextureAtlas(const TextureAtlas &)=delete;
+  TextureAtlas &operator=(const TextureAtlas &)=delete;
+
+  int pageSize() const { return m_pageSize; }
+  int maxTextureSize() const { return m_maxTextureSize; }
+  bool fits(int _width, int _height) const;
+  // copy _image into a page, false if it has no pixels, is too big or the key
+  // is already in the atlas
+  bool insert(Key _key, const TGAImage &_image);
+  // free the space, this may repack the page
+  void remove(Key _key);
+  bool find(Key _key, AtlasRegion &_region) const;
+  size_t pageCount() const;
+  // _f is called with the page pixels, size and generation with the atlas
+  // locked so nothing moves while it reads (e.g. to upload to the GPU)
+  void withPage(size_t _page, const std::function<void(const uint8_t *,int,uint64_t)> &_f) const;
+  // fraction of the used area of a page that is holes
+  float fragmentation(size_t _page) const;
+  size_t memoryBytes() const;
+
+private:
+  struct Shelf
+  {
+    int y;
+    int height;
+    // next free column
+    int x;
+  };
+  struct Page
+  {
+    std::vector<uint8_t> pixels;
+    std::vector<Shelf> shelves;
+    int nextShelfY = 0;
+    // area of the textures still here and of everything ever placed since
+    // the last repack, the difference is holes
+    size_t liveArea = 0;
+    size_t usedArea = 0;
+    uint64_t generation = 0;
+  };
+  struct Slot
+  {
+    size_t page;
+    int x;
+    int y;
+    int width;
+    int height;
+  };
+  bool place(Page &_page, int _width, int _height, int &_x, int &_y) const;
+  float fragmentation(const Page &_page) const;
+  void repack(size_t _page);
+  int m_pageSize;
+  int m_maxTextureSize;
+  mutable std::mutex m_mutex;
+  std::vector<Page> m_pages;
+  std::unordered_map<Key,Slot> m_slots;
+};
+
+#endif
@@ -1,5 +1,8 @@
 #include "Texture.h"
+#include "TextureAtlas.h"
 #include <cstdlib>
+#include <iostream>
+#include <string>
 
 void foo()
 {
@@ -8,7 +11,7 @@ void foo()
 }
 
 
-int main()
+int main(int argc, char **argv)
 {
   Texture::getTexture("diffuse.tga");
   Texture::printCurrentTexture();
@@ -16,7 +19,82 @@ int main()
   Texture::printCurrentTexture();
   Texture::getTexture("diffuse.tga");
   Texture::printCurrentTexture();
+  // resolve the name once, later lookups skip the hashing
+  TextureId diffuse = Texture::intern("diffuse.tga");
+  Texture::getTexture(diffuse);
   foo();
+  // the frame thread can carry on while these load, both requests for
+  // normal.tga share the one load
+  auto normal = Texture::getTextureAsync("normal.tga");
+  auto again = Texture::getTextureAsync("normal.tga");
+  normal.wait();
+  again.wait();
+  // a future keeps its texture pinned, drop them before shrinking the budget
+  normal = Texture::Future();
+  again = Texture::Future();
+  // shrink the budget, only the texture we are still holding survives
+  auto held = Texture::getTexture("specular.tga");
+  Texture::setMemoryBudget(held->sizeInBytes());
+  Texture::printCurrentTexture();
+  // the id survives eviction, using it just loads the texture again
+  Texture::setMemoryBudget(static_cast<size_t>(-1));
+  Texture::getTexture(diffuse);
+  Texture::printCurrentTexture();
+  // decoded files are kept here between runs
+  if (const char *dir = std::getenv("TEXTURE_CACHE_DIR"))
+  {
+    Texture::setDiskCache(dir);
+  }
+  // a real file passed on the command line, a manifest of them with --preload
+  // (add --atlas to pack them) or several small ones to pack into an atlas
+  // with --atlas
+  if (argc > 2 && std::string(argv[1]) == "--atlas")
+  {
+    Texture::setAtlas(2048, 128);
+    for (int i=2; i<argc; ++i)
+    {
+      auto t = Texture::getTexture(argv[i]);
+      AtlasRegion r;
+      if (t->atlasRegion(r))
+      {
+        std::cout << t->name() << " page " << r.page << " uv (" << r.u0 << ", " << r.v0
+                  << ") - (" << r.u1 << ", " << r.v1 << ")" << std::endl;
+      }
+      else
+      {
+        std::cout << t->name() << " not in the atlas" << std::endl;
+      }
+    }
+  }
+  else if (argc > 2 && std::string(argv[1]) == "--preload")
+  {
+    if (argc > 3 && std::string(argv[3]) == "--atlas")
+    {
+      Texture::setAtlas(2048, 128);
+    }
+    PreloadResult r = Texture::preload(argv[2], 0, [](size_t _done, size_t _total)
+    {
+      std::cout << "\rloaded " << _done << " / " << _total << std::flush;
+    });
+    std::cout << "\n" << r.loaded << " loaded " << r.failed << " failed in "
+              << r.seconds << "s" << std::endl;
+    if (auto atlas = Texture::atlas())
+    {
+      std::cout << atlas->pageCount() << " atlas pages" << std::endl;
+    }
+  }
+  else if (argc > 1)
+  {
+    auto t = Texture::getTexture(argv[1]);
+    std::cout << t->name() << " " << t->width() << "x" << t->height()
+              << " channels " << t->channels()
+              << (t->image().isZeroCopy() ? " mapped" : " decoded") << std::endl;
+  }
+  // anything not used since the last call is packed, the next lookup unpacks it
+  Texture::compressIdle();
+  Texture::compressIdle();
+  Texture::dumpStats(std::cout);
+  std::cout << std::endl;
   return EXIT_SUCCESS;
 }
 
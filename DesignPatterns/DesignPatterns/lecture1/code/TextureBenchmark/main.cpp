@@ -0,0 +1,251 @@
+// benchmark for the compressed texture tier, the results are written to stdout
+// as JSON and progress goes to stderr so the two can be redirected separately
+//   TextureBenchmark [--size n] [--textures n] [--dir path] > results.json
+// the cache section writes its TGA files into --dir (default .) and removes
+// them afterwards. Build with something like
+// g++ -O3 -std=c++17 -pthread -I../Texture -I../BenchmarkCommon main.cpp ../Texture/Texture.cpp ../Texture/Codec.cpp ../Texture/TGA.cpp ../Texture/MappedFile.cpp ../Texture/LoaderPool.cpp ../Texture/DiskCache.cpp ../Texture/TextureAtlas.cpp
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "Codec.h"
+#include "JsonRecord.h"
+#include "Texture.h"
+
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point _start)
+{
+  return std::chrono::duration<double>(Clock::now()-_start).count();
+}
+
+// RGBA test images with different amounts of redundancy
+enum class Pattern { Flat, Blocks, Gradient, Noise };
+static const char *patternName(Pattern _p)
+{
+  switch (_p)
+  {
+    case Pattern::Flat : return "flat";
+    case Pattern::Blocks : return "blocks";
+    case Pattern::Gradient : return "gradient";
+    default : return "noise";
+  }
+}
+
+static std::vector<uint8_t> makeImage(Pattern _pattern, int _size, unsigned _seed)
+{
+  std::vector<uint8_t> pixels(size_t(_size)*_size*4);
+  std::mt19937 rng(_seed);
+  for (int y=0; y<_size; ++y)
+  {
+    for (int x=0; x<_size; ++x)
+    {
+      uint8_t *p = &pixels[(size_t(y)*_size+x)*4];
+      switch (_pattern)
+      {
+        case Pattern::Flat : p[0]=40; p[1]=80; p[2]=120; break;
+        // UI style art, flat 16x16 tiles
+        case Pattern::Blocks :
+          p[0]=static_cast<uint8_t>((x/16)*37+_seed);
+          p[1]=static_cast<uint8_t>((y/16)*59);
+          p[2]=static_cast<uint8_t>(((x/16)^(y/16))*13);
+        break;
+        case Pattern::Gradient :
+          p[0]=static_cast<uint8_t>(x*255/_size);
+          p[1]=static_cast<uint8_t>(y*255/_size);
+          p[2]=static_cast<uint8_t>(_seed);
+        break;
+        default :
+          p[0]=static_cast<uint8_t>(rng());
+          p[1]=static_cast<uint8_t>(rng());
+          p[2]=static_cast<uint8_t>(rng());
+        break;
+      }
+      p[3]=255;
+    }
+  }
+  return pixels;
+}
+
+// repeat until at least a quarter of a second has gone so small images still
+// give a stable figure
+template <typename F>
+static double bytesPerSecond(size_t _bytes, F _f)
+{
+  size_t runs=0;
+  auto start = Clock::now();
+  double elapsed=0.0;
+  do
+  {
+    _f();
+    ++runs;
+    elapsed = secondsSince(start);
+  } while (elapsed < 0.25);
+  return double(_bytes)*runs/elapsed;
+}
+
+static std::string codecCase(Pattern _pattern, int _size)
+{
+  std::vector<uint8_t> pixels = makeImage(_pattern, _size, 7);
+  std::vector<uint8_t> packed;
+  double compress = bytesPerSecond(pixels.size(), [&]{ Codec::compress(pixels.data(), pixels.size(), packed); });
+  std::vector<uint8_t> out(pixels.size());
+  bool ok=true;
+  double decompress = bytesPerSecond(pixels.size(), [&]
+  {
+    ok = ok && Codec::decompress(packed.data(), packed.size(), out.data(), out.size());
+  });
+  ok = ok && out == pixels;
+  JsonRecord r;
+  r.add("pattern", patternName(_pattern)).add("size", _size)
+   .add("bytes", pixels.size()).add("compressed_bytes", packed.size())
+   .add("ratio", double(packed.size())/pixels.size())
+   .add("bytes_saved", pixels.size() > packed.size() ? pixels.size()-packed.size() : 0)
+   .add("compress_mb_per_s", compress/1e6)
+   .add("decompress_mb_per_s", decompress/1e6)
+   .add("round_trip_ok", ok);
+  return r.str();
+}
+
+// run length encoded 32 bit true colour, so loading decodes the pixels into
+// memory of their own rather than mapping the file. That is what the cold tier
+// can actually give back, a mapped file costs no heap to begin with.
+static void writeTGA(const std::string &_fname, const std::vector<uint8_t> &_pixels, int _size)
+{
+  uint8_t header[18] = {};
+  header[2] = 10;
+  header[12] = static_cast<uint8_t>(_size);
+  header[13] = static_cast<uint8_t>(_size >> 8);
+  header[14] = header[12];
+  header[15] = header[13];
+  header[16] = 32;
+  std::vector<uint8_t> packed;
+  size_t count = _pixels.size()/4;
+  auto same = [&](size_t _a, size_t _b) { return std::memcmp(&_pixels[_a*4], &_pixels[_b*4], 4) == 0; };
+  for (size_t i=0; i<count;)
+  {
+    // a run of two or more becomes one repeat packet, anything else is
+    // gathered into a literal packet, both hold at most 128 pixels
+    size_t run=1;
+    while (run < 128 && i+run < count && same(i, i+run))
+    {
+      ++run;
+    }
+    if (run > 1)
+    {
+      packed.push_back(static_cast<uint8_t>(0x80 | (run-1)));
+      packed.insert(packed.end(), &_pixels[i*4], &_pixels[i*4]+4);
+      i += run;
+      continue;
+    }
+    size_t literal=1;
+    while (literal < 128 && i+literal < count &&
+           !(i+literal+1 < count && same(i+literal, i+literal+1)))
+    {
+      ++literal;
+    }
+    packed.push_back(static_cast<uint8_t>(literal-1));
+    packed.insert(packed.end(), &_pixels[i*4], &_pixels[(i+literal)*4]);
+    i += literal;
+  }
+  std::ofstream out(_fname, std::ios::binary);
+  out.write(reinterpret_cast<const char *>(header), sizeof(header));
+  out.write(reinterpret_cast<const char *>(packed.data()), static_cast<std::streamsize>(packed.size()));
+}
+
+// Load a working set of mixed textures, compress the lot then touch them all
+// again so every lookup is a cold hit. Shows the memory the tier saves against
+// what it costs to come back.
+static std::string cacheCase(const std::string &_dir, int _textures, int _size)
+{
+  const Pattern patterns[] = {Pattern::Flat, Pattern::Blocks, Pattern::Gradient, Pattern::Noise};
+  std::vector<std::string> names;
+  for (int i=0; i<_textures; ++i)
+  {
+    names.push_back(_dir+"/texture_benchmark_"+std::to_string(i)+".tga");
+    writeTGA(names.back(), makeImage(patterns[i%4], _size, static_cast<unsigned>(i)), _size);
+  }
+  auto start = Clock::now();
+  size_t decoded=0;
+  for (auto &n : names)
+  {
+    auto t = Texture::getTexture(n);
+    decoded += t->width() > 0 && !t->image().isZeroCopy() ? 1 : 0;
+  }
+  double loadSeconds = secondsSince(start);
+  size_t hotBytes = Texture::bytesResident();
+  // the first pass only clears the referenced flags
+  Texture::compressIdle();
+  start = Clock::now();
+  size_t demoted = Texture::compressIdle();
+  double compressSeconds = secondsSince(start);
+  size_t coldBytes = Texture::bytesResident();
+  start = Clock::now();
+  for (auto &n : names)
+  {
+    Texture::getTexture(n);
+  }
+  double warmSeconds = secondsSince(start);
+  for (auto &n : names)
+  {
+    std::remove(n.c_str());
+  }
+  JsonRecord r;
+  r.add("textures", _textures).add("size", _size)
+   .add("load_ms", loadSeconds*1e3)
+   .add("hot_bytes", hotBytes).add("cold_bytes", coldBytes)
+   .add("demoted", demoted)
+   .add("decoded", decoded)
+   .add("memory_saved", hotBytes > 0 ? (double(hotBytes)-double(coldBytes))/double(hotBytes) : 0.0)
+   .add("compress_ms", compressSeconds*1e3)
+   .add("warm_ms", warmSeconds*1e3)
+   .add("warm_us_per_texture", warmSeconds*1e6/_textures);
+  return r.str();
+}
+
+int main(int argc, char **argv)
+{
+  int size = 1024;
+  int textures = 64;
+  std::string dir = ".";
+  for (int i=1; i+1<argc; i+=2)
+  {
+    if (std::strcmp(argv[i], "--size") == 0)
+    {
+      size = std::atoi(argv[i+1]);
+    }
+    else if (std::strcmp(argv[i], "--textures") == 0)
+    {
+      textures = std::atoi(argv[i+1]);
+    }
+    else if (std::strcmp(argv[i], "--dir") == 0)
+    {
+      dir = argv[i+1];
+    }
+  }
+
+  std::cerr<<"codec\n";
+  std::vector<std::string> codec;
+  for (int s : {size/4, size})
+  {
+    for (Pattern p : {Pattern::Flat, Pattern::Blocks, Pattern::Gradient, Pattern::Noise})
+    {
+      codec.push_back(codecCase(p, s));
+    }
+  }
+
+  std::cerr<<"cache\n";
+  std::vector<std::string> cache;
+  cache.push_back(cacheCase(dir, textures, size/4));
+
+  std::cout<<"{\n";
+  writeSection("codec", codec, false);
+  writeSection("cache", cache, true);
+  std::cout<<"}\n";
+  return EXIT_SUCCESS;
+}